@@ -1,63 +1,119 @@
 #pragma once
 
-#include <cmath>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <bit>
+#include <type_traits>
 
 #include "enums.hpp"
 #include "config.hpp"
 
-namespace Actions {
-    std::string display_name[int(Action::COUNT)];
-    int cp_cost[int(Action::COUNT)], dur_cost[int(Action::COUNT)];
-    unsigned pim[int(Action::COUNT)], qim[int(Action::COUNT)];
-    Action combo_action[int(Action::COUNT)];
-
-    void set_parameters(const Action action, std::string _display_name, int _cp_cost, int _dur_cost, float _pim, float _qim, Action _combo_action) {
-        display_name[int(action)] = _display_name;
-        cp_cost[int(action)] = _cp_cost;
-        dur_cost[int(action)] = _dur_cost;
-        pim[int(action)] = static_cast<unsigned>(std::round(_pim * Config::BASE_PROGRESS_MULTIPLIER));
-        qim[int(action)] = static_cast<unsigned>(std::round(_qim * Config::BASE_QUALITY_MULTIPLIER));
-        combo_action[int(action)] = _combo_action;
-    }
+// Recipe independent parameters of an action, potencies in percent of the recipe's base multipliers.
+struct ActionInfo {
+    Action action;
+    const char *display_name;
+    int cp_cost, dur_cost;
+    unsigned progress_percent, quality_percent;
+    Action combo_action;
+};
 
-    void init() {
-        set_parameters(Action::Null, "Null", 0, 0, 0.00, 0.00, Action::Null);
-        set_parameters(Action::None, "None", 0, 0, 0.00, 0.00, Action::Null);
-        set_parameters(Action::BasicSynthesis, "Basic Synthesis", 0, 10, 1.20, 0.00, Action::Null);
-        set_parameters(Action::BasicTouch, "Basic Touch", 18, 10, 0.00, 1.00, Action::Null);
-        set_parameters(Action::MasterMend, "Master's Mend", 88, 0, 0.00, 0.00, Action::Null);
+namespace Actions {
+    constexpr ActionInfo INFO[int(Action::COUNT)] = {
+        {Action::Null, "Null", 0, 0, 0, 0, Action::Null},
+        {Action::None, "None", 0, 0, 0, 0, Action::Null},
+        {Action::BasicSynthesis, "Basic Synthesis", 0, 10, 120, 0, Action::Null},
+        {Action::BasicTouch, "Basic Touch", 18, 10, 0, 100, Action::Null},
+        {Action::MasterMend, "Master's Mend", 88, 0, 0, 0, Action::Null},
         // Hasty Touch
         // Rapid Synthesis
-        set_parameters(Action::Observe, "Observe", 7, 0, 0.00, 0.00, Action::Null);
+        {Action::Observe, "Observe", 7, 0, 0, 0, Action::Null},
         // Tricks of the Trade
-        set_parameters(Action::WasteNot, "Waste Not", 56, 0, 0.00, 0.00, Action::Null);
-        set_parameters(Action::Veneration, "Veneration", 18, 0, 0.00, 0.00, Action::Null);
-        set_parameters(Action::StandardTouch, "Standard Touch", 18, 10, 0.00, 1.25, Action::BasicTouch);
-        set_parameters(Action::GreatStrides, "Great Strides", 32, 0, 0.00, 0.00, Action::Null);
-        set_parameters(Action::Innovation, "Innovation", 18, 0, 0.00, 0.00, Action::Null);
+        {Action::WasteNot, "Waste Not", 56, 0, 0, 0, Action::Null},
+        {Action::Veneration, "Veneration", 18, 0, 0, 0, Action::Null},
+        {Action::StandardTouch, "Standard Touch", 18, 10, 0, 125, Action::BasicTouch},
+        {Action::GreatStrides, "Great Strides", 32, 0, 0, 0, Action::Null},
+        {Action::Innovation, "Innovation", 18, 0, 0, 0, Action::Null},
         // Final Appraisal
-        set_parameters(Action::WasteNot2, "Waste Not II", 98, 0, 0.00, 0.00, Action::Null);
-        set_parameters(Action::ByregotsBlessing, "Byregot's Blessing", 24, 10, 0.00, 1.00, Action::Null);
-        set_parameters(Action::PreciseTouch, "Precise Touch", 18, 10, 0.00, 1.50, Action::Null);
-        set_parameters(Action::MuscleMemory, "Muscle Memory", 6, 10, 3.00, 0.00, Action::None);
-        set_parameters(Action::CarefulSynthesis, "Careful Synthesis", 7, 10, 1.80, 0.00, Action::Null);
-        set_parameters(Action::Manipulation, "Manipulation", 96, 0, 0.00, 0.00, Action::Null);
-        set_parameters(Action::PrudentTouch, "Prudent Touch", 25, 5, 0.00, 1.00, Action::Null);
-        set_parameters(Action::FocusedSynthesis, "Focused Synthesis", 5, 10, 2.00, 0.00, Action::Observe);
-        set_parameters(Action::FocusedTouch, "Focused Touch", 18, 10, 0.00, 1.50, Action::Observe);
-        set_parameters(Action::Reflect, "Reflect", 6, 10, 0.00, 1.00, Action::None);
-        set_parameters(Action::PreparatoryTouch, "Preparatory Touch", 40, 20, 0.00, 2.00, Action::Null);
-        set_parameters(Action::Groundwork, "Groundwork", 18, 20, 3.60, 0.00, Action::Null);
-        set_parameters(Action::DelicateSynthesis, "Delicate Synthesis", 32, 10, 1.00, 1.00, Action::Null);
-        set_parameters(Action::IntensiveSynthesis, "Intensive Synthesis", 6, 10, 4.00, 1.00, Action::Null);
+        {Action::WasteNot2, "Waste Not II", 98, 0, 0, 0, Action::Null},
+        {Action::ByregotsBlessing, "Byregot's Blessing", 24, 10, 0, 100, Action::Null},
+        {Action::PreciseTouch, "Precise Touch", 18, 10, 0, 150, Action::Null},
+        {Action::MuscleMemory, "Muscle Memory", 6, 10, 300, 0, Action::None},
+        {Action::CarefulSynthesis, "Careful Synthesis", 7, 10, 180, 0, Action::Null},
+        {Action::Manipulation, "Manipulation", 96, 0, 0, 0, Action::Null},
+        {Action::PrudentTouch, "Prudent Touch", 25, 5, 0, 100, Action::Null},
+        {Action::FocusedSynthesis, "Focused Synthesis", 5, 10, 200, 0, Action::Observe},
+        {Action::FocusedTouch, "Focused Touch", 18, 10, 0, 150, Action::Observe},
+        {Action::Reflect, "Reflect", 6, 10, 0, 100, Action::None},
+        {Action::PreparatoryTouch, "Preparatory Touch", 40, 20, 0, 200, Action::Null},
+        {Action::Groundwork, "Groundwork", 18, 20, 360, 0, Action::Null},
+        {Action::DelicateSynthesis, "Delicate Synthesis", 32, 10, 100, 100, Action::Null},
+        {Action::IntensiveSynthesis, "Intensive Synthesis", 6, 10, 400, 100, Action::Null},
         // Trained Eye
-        set_parameters(Action::AdvancedTouch, "Advanced Touch", 18, 10, 0.00, 1.50, Action::StandardTouch);
-        set_parameters(Action::PrudentSynthesis, "Prudent Synthesis", 18, 5, 1.80, 0.00, Action::Null);
-        set_parameters(Action::TrainedFinesse, "Trained Finesse", 32, 0, 0.00, 1.00, Action::Null);
+        {Action::AdvancedTouch, "Advanced Touch", 18, 10, 0, 150, Action::StandardTouch},
+        {Action::PrudentSynthesis, "Prudent Synthesis", 18, 5, 180, 0, Action::Null},
+        {Action::TrainedFinesse, "Trained Finesse", 32, 0, 0, 100, Action::Null},
+    };
+
+    constexpr bool __info_in_enum_order() {
+        for (int i = 0; i < int(Action::COUNT); ++i)
+            if (int(INFO[i].action) != i) return false;
+        return true;
+    }
+    static_assert(__info_in_enum_order(), "Actions::INFO must list every action in enum order");
+
+    template<typename T, std::size_t... I>
+    constexpr std::array<T, sizeof...(I)> __column(T ActionInfo::*field, std::index_sequence<I...>) {
+        return {INFO[I].*field...};
+    }
+
+    constexpr std::array<const char *, int(Action::COUNT)> display_name = __column(&ActionInfo::display_name, std::make_index_sequence<int(Action::COUNT)>());
+    constexpr std::array<int, int(Action::COUNT)> cp_cost = __column(&ActionInfo::cp_cost, std::make_index_sequence<int(Action::COUNT)>());
+    constexpr std::array<int, int(Action::COUNT)> dur_cost = __column(&ActionInfo::dur_cost, std::make_index_sequence<int(Action::COUNT)>());
+    constexpr std::array<Action, int(Action::COUNT)> combo_action = __column(&ActionInfo::combo_action, std::make_index_sequence<int(Action::COUNT)>());
+
+    // quality multiplier classes of the conditions: Normal, Good, Excellent, Poor
+    constexpr int QUALITY_CONDITIONS = 4, MAX_INNER_QUIET = 10;
+    constexpr int quality_condition[int(Condition::COUNT)] = {0, 1, 2, 3, 0, 0, 0, 0};
+
+    // filled by init() for the current recipe
+    Recipe recipe;
+    unsigned pim[int(Action::COUNT)], qim[int(Action::COUNT)];
+    // quality potency by condition class, Inner Quiet stacks, Great Strides, Innovation and action
+    unsigned quality_potency[QUALITY_CONDITIONS][MAX_INNER_QUIET + 1][2][2][int(Action::COUNT)];
+
+    // The original floating point quality formula. Its float rounding is not reproducible with exact
+    // fixed point (e.g. 1.5 * 1.8 lands just below 2.7), so init() tabulates it once per recipe and
+    // the search only ever reads the table.
+    unsigned __float_quality_potency(const int condition, const int inner_quiet, const bool great_strides, const bool innovation, const Action action) {
+        constexpr float CONDITION_QIM[QUALITY_CONDITIONS] = {1.00, 1.50, 4.00, 0.50};
+        float effect_qim = 1.00 + inner_quiet * 0.10;
+        if (great_strides) effect_qim += 1.0;
+        if (innovation) effect_qim += 0.5;
+        float action_qim = qim[int(action)];
+        if (action == Action::ByregotsBlessing) action_qim += recipe.base_quality_multiplier * inner_quiet * 0.20;
+        return (unsigned)(CONDITION_QIM[condition] * effect_qim * action_qim);
+    }
+
+    // returns false, keeping the current recipe, if its cp or durability do not fit a State
+    bool init(const Recipe &_recipe = Recipe()) {
+        if (!_recipe.in_range()) return false;
+        recipe = _recipe;
+        for (int i = 0; i < int(Action::COUNT); ++i) { // rounds half up, same as std::round on the old float multipliers
+            pim[i] = (INFO[i].progress_percent * recipe.base_progress_multiplier + 50) / 100;
+            qim[i] = (INFO[i].quality_percent * recipe.base_quality_multiplier + 50) / 100;
+        }
+        for (int c = 0; c < QUALITY_CONDITIONS; ++c)
+            for (int iq = 0; iq <= MAX_INNER_QUIET; ++iq)
+                for (int gs = 0; gs < 2; ++gs)
+                    for (int inno = 0; inno < 2; ++inno)
+                        for (int i = 0; i < int(Action::COUNT); ++i)
+                            quality_potency[c][iq][gs][inno][i] = __float_quality_potency(c, iq, gs, inno, Action(i));
+        return true;
     }
 }
 
-const Action ALL_ACTIONS[] = {
+constexpr Action ALL_ACTIONS[] = {
         Action::BasicSynthesis,
         Action::BasicTouch,
         Action::MasterMend,
@@ -86,6 +142,24 @@ const Action ALL_ACTIONS[] = {
         Action::TrainedFinesse
     };
 
-bool is_combo_action(const Action action) {
+constexpr bool is_combo_action(const Action action) {
     return action == Action::Observe || action == Action::BasicTouch || action == Action::StandardTouch;
-}
\ No newline at end of file
+}
+
+// Calls f.template operator()<action>() for every action in ALL_ACTIONS, in order. The body is
+// compiled once per action, so checks on the action fold away instead of being dispatched at runtime.
+template<typename F> void for_each_action(F &&f) {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (f.template operator()<ALL_ACTIONS[I]>(), ...);
+    }(std::make_index_sequence<std::size(ALL_ACTIONS)>());
+}
+
+// Same as for_each_action(f) for only the actions whose bit is set in mask, bit i standing for
+// ALL_ACTIONS[i]. Jumps from set bit to set bit through a table of the specialized bodies.
+template<typename F> void for_each_action(std::uint32_t mask, F &&f) {
+    typedef std::remove_reference_t<F> Body;
+    static constexpr auto table = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<void (*)(Body &), sizeof...(I)>{+[](Body &body) { body.template operator()<ALL_ACTIONS[I]>(); }...};
+    }(std::make_index_sequence<std::size(ALL_ACTIONS)>());
+    for (; mask != 0; mask &= mask - 1) table[std::countr_zero(mask)](f);
+}
@@ -0,0 +1,191 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+
+#include <sys/resource.h>
+
+#include "enums.hpp"
+#include "state.hpp"
+#include "actions.hpp"
+#include "solve.hpp"
+#include "config.hpp"
+
+// Benchmark over a matrix of recipes. Every case is solved cold (empty memo) warmup times without
+// being measured, then repetitions times. Progress is printed to stderr, one JSON document with
+// every sample and its summary statistics to stdout, so that runs can be diffed.
+//
+// With --budget-sweep, solves one recipe again under memo budgets shrinking below its working set
+// and fails if the answer changes or a step slows down by more than SWEEP_MAX_SLOWDOWN, so that
+// eviction degrades gradually instead of thrashing.
+//
+// usage: bench [--repetitions N] [--warmup N] [--threads N]
+//        bench --budget-sweep [--threads N]
+
+struct Sample {
+    double wall_ms;
+    std::size_t states, nodes_expanded, entries, quality, memo_bytes;
+    long peak_rss_kb;
+};
+
+// Peak RSS of the process. Linux lets us reset the high-water mark between cases, elsewhere
+// the value is the peak since start.
+bool reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    return clear_refs && (clear_refs << "5").good();
+}
+
+long peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line); )
+        if (line.rfind("VmHWM:", 0) == 0) return std::atol(line.c_str() + 6);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+Sample run(const Recipe &recipe, const unsigned threads, const std::size_t memory_budget = 0) {
+    Actions::init(recipe);
+    reset_peak_rss();
+    auto solver = std::make_unique<Solver>(threads, BoundMode::Off, memory_budget);
+    const State init(recipe.max_cp, recipe.max_durability);
+
+    const auto t1 = std::chrono::steady_clock::now();
+    solver->solve(init);
+    const auto t2 = std::chrono::steady_clock::now();
+
+    const MemoryUsage usage = solver->get_memory_usage();
+    Sample sample;
+    sample.wall_ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    sample.states = usage.states;
+    sample.nodes_expanded = solver->get_search_stats().nodes_expanded;
+    sample.entries = usage.entries;
+    sample.memo_bytes = usage.table_bytes + usage.front_bytes;
+    sample.quality = solver->get_max_quality(init, recipe.max_progress);
+    sample.peak_rss_kb = peak_rss_kb();
+    return sample;
+}
+
+// nearest rank percentile
+double percentile(std::vector<double> values, const double p) {
+    std::sort(values.begin(), values.end());
+    const std::size_t rank = std::max<std::size_t>(1, std::size_t(p * values.size() + 0.999999));
+    return values[std::min(rank, values.size()) - 1];
+}
+
+constexpr double SWEEP_MAX_SLOWDOWN = 8;
+
+int budget_sweep(const unsigned threads) {
+    Recipe recipe;
+    recipe.max_cp = 250;
+    recipe.max_durability = 70;
+    recipe.max_progress = 2000;
+    recipe.max_quality = 5000;
+    const Sample unbounded = run(recipe, threads);
+    std::cout << "{\n  \"working_set_bytes\": " << unbounded.memo_bytes << ", \"threads\": " << threads
+              << ",\n  \"steps\": [\n    {\"budget_bytes\": 0, \"wall_ms\": " << unbounded.wall_ms << '}';
+    bool ok = true;
+    double previous_ms = unbounded.wall_ms;
+    for (const double fraction : {0.875, 0.75, 0.625, 0.5, 0.375, 0.25}) {
+        const std::size_t budget = std::size_t(unbounded.memo_bytes * fraction);
+        const Sample sample = run(recipe, threads, budget);
+        const bool step_ok = sample.quality == unbounded.quality && sample.wall_ms <= previous_ms * SWEEP_MAX_SLOWDOWN;
+        std::cerr << "budget " << fraction << " of the working set: " << sample.wall_ms << "ms" << (step_ok ? "\n" : " FAILED\n");
+        std::cout << ",\n    {\"budget_bytes\": " << budget << ", \"wall_ms\": " << sample.wall_ms
+                  << ", \"quality\": " << sample.quality << ", \"ok\": " << (step_ok ? "true" : "false") << '}';
+        ok = ok && step_ok;
+        previous_ms = sample.wall_ms;
+    }
+    std::cout << "\n  ]\n}\n";
+    return ok ? 0 : 1;
+}
+
+struct Options {
+    int repetitions = 5, warmup = 1;
+    unsigned threads = 1;
+    bool budget_sweep = false;
+};
+
+// fills options from argv, returns false on an unknown flag or a flag without its value
+bool parse_options(const int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        auto number = [&](auto &out) {
+            const char *text = i + 1 < argc ? argv[++i] : nullptr;
+            if (text == nullptr) return false;
+            char *end;
+            const long long parsed = std::strtoll(text, &end, 10);
+            if (*text == '\0' || *end != '\0' || parsed < 0) return false;
+            out = parsed;
+            return true;
+        };
+        bool ok = true;
+        if (flag == "--repetitions") ok = number(options.repetitions) && options.repetitions != 0;
+        else if (flag == "--warmup") ok = number(options.warmup);
+        else if (flag == "--threads") ok = number(options.threads) && options.threads != 0;
+        else if (flag == "--budget-sweep") options.budget_sweep = true;
+        else ok = false;
+        if (!ok) {
+            std::cerr << "Bad argument " << flag << ", see the usage at the top of bench.cpp\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+    if (options.budget_sweep) return budget_sweep(options.threads);
+    const int repetitions = options.repetitions;
+    const int warmup = options.warmup;
+    const unsigned threads = options.threads;
+
+    std::vector<Recipe> matrix;
+    for (const int cp : {250, 300, 350})
+        for (const int durability : {35, 70})
+            for (const auto &[progress, quality] : {std::pair{2000u, 5000u}, std::pair{3000u, 8000u}}) {
+                Recipe recipe;
+                recipe.max_cp = cp;
+                recipe.max_durability = durability;
+                recipe.max_progress = progress;
+                recipe.max_quality = quality;
+                matrix.push_back(recipe);
+            }
+
+    std::cout << "{\n  \"repetitions\": " << repetitions << ", \"warmup\": " << warmup << ", \"threads\": " << threads
+              << ", \"compiler\": \"" << __VERSION__ << "\",\n  \"cases\": [";
+    for (std::size_t i = 0; i != matrix.size(); ++i) {
+        const Recipe &recipe = matrix[i];
+        std::cerr << "cp " << recipe.max_cp << " durability " << recipe.max_durability
+                  << " progress " << recipe.max_progress << " quality " << recipe.max_quality << ": ";
+        for (int rep = 0; rep < warmup; ++rep) run(recipe, threads);
+        std::vector<Sample> samples;
+        std::vector<double> wall_ms, states_per_s;
+        for (int rep = 0; rep < repetitions; ++rep) {
+            samples.push_back(run(recipe, threads));
+            wall_ms.push_back(samples.back().wall_ms);
+            states_per_s.push_back(samples.back().states / (samples.back().wall_ms / 1000));
+        }
+        const Sample &last = samples.back(); // everything but time and rss is deterministic
+        std::cerr << percentile(wall_ms, 0.5) << "ms median\n";
+
+        std::cout << (i == 0 ? "" : ",") << "\n    {\"max_cp\": " << recipe.max_cp << ", \"max_durability\": " << recipe.max_durability
+                  << ", \"max_progress\": " << recipe.max_progress << ", \"max_quality\": " << recipe.max_quality
+                  << ", \"quality\": " << last.quality << ", \"unique_states\": " << last.states
+                  << ", \"nodes_expanded\": " << last.nodes_expanded
+                  << ", \"avg_front_size\": " << (last.states == 0 ? 0 : double(last.entries) / last.states)
+                  << ",\n     \"wall_ms\": {\"min\": " << percentile(wall_ms, 0) << ", \"p50\": " << percentile(wall_ms, 0.5)
+                  << ", \"p90\": " << percentile(wall_ms, 0.9) << ", \"max\": " << percentile(wall_ms, 1) << '}'
+                  << ", \"states_per_s_p50\": " << percentile(states_per_s, 0.5)
+                  << ",\n     \"samples\": [";
+        for (std::size_t j = 0; j != samples.size(); ++j)
+            std::cout << (j == 0 ? "" : ", ") << "{\"wall_ms\": " << samples[j].wall_ms << ", \"peak_rss_kb\": " << samples[j].peak_rss_kb << '}';
+        std::cout << "]}";
+    }
+    std::cout << "\n  ]\n}\n";
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+#include "enums.hpp"
+#include "actions.hpp"
+#include "state.hpp"
+#include "config.hpp"
+
+enum struct BoundMode {
+    Off,  // plain search, every subtree is solved
+    Root, // get_best_action skips child subtrees whose upper bound cannot beat the best child so far
+};
+
+// Cheap over-estimates of the progress and quality still reachable from a state, assuming its
+// condition holds for every future step like the search does (see Canonical in pruning.hpp). Good,
+// Excellent and Malleable multiply every step, and the actions they allow are credited once more as
+// one-shot terms. Sturdy and Primed stretch the durability budget. Poor and Centered are bounded
+// like Normal.
+//
+// Both bounds are relaxed knapsacks: every step is assumed to run under the strongest buffs, Waste Not
+// is free, and spare cp can be turned into durability at Manipulation's rate. Quality is bounded by cp
+// (combo actions pay for their whole combo) and by durability, whichever is tighter. Progress is only
+// bounded by durability, since Basic Synthesis is free. Byregot's Blessing is credited per Inner Quiet
+// stack, 0.2 for every stack a touch gains, as every stack feeds at most one Byregot's Blessing.
+namespace Bound {
+    struct Rates {
+        Recipe recipe;
+        bool valid = false;
+        double touch_per_cp = 0, touch_per_durability = 0, touch_free_per_cp = 0, touch_max = 0, combo_max = 0, reflect = 0;
+        double synth_per_durability = 0, synth_max = 0, muscle_memory = 0;
+        double durability_per_cp = 0, primed_durability_per_cp = 0;
+    };
+
+    int __inner_quiet_gain(const Action action) {
+        if (action == Action::ByregotsBlessing) return 0;
+        if (action == Action::PreciseTouch || action == Action::PreparatoryTouch || action == Action::Reflect) return 2;
+        return 1;
+    }
+
+    bool __needs_good_condition(const Action action) {
+        return action == Action::PreciseTouch || action == Action::IntensiveSynthesis;
+    }
+
+    // durability cost under the cheapest circumstances, Prudent actions cannot be combined with Waste Not
+    double __min_durability_cost(const Action action) {
+        const int cost = Actions::dur_cost[int(action)];
+        if (action == Action::PrudentTouch || action == Action::PrudentSynthesis) return cost;
+        return (cost + 1) / 2;
+    }
+
+    const Rates &__rates() {
+        static thread_local Rates rates;
+        if (rates.valid && rates.recipe.same_action_table(Actions::recipe)) return rates;
+        rates = Rates();
+        rates.recipe = Actions::recipe;
+        rates.valid = true;
+        rates.durability_per_cp = std::max(8 * 5 / double(Actions::cp_cost[int(Action::Manipulation)]),
+                                           30 / double(Actions::cp_cost[int(Action::MasterMend)]));
+        rates.primed_durability_per_cp = std::max(rates.durability_per_cp, (8 + 2) * 5 / double(Actions::cp_cost[int(Action::Manipulation)]));
+
+        auto touch_value = [](const Action action) {
+            return Actions::qim[int(action)] + 0.2 * Actions::recipe.base_quality_multiplier * __inner_quiet_gain(action);
+        };
+        for (const Action action : ALL_ACTIONS) {
+            if (__needs_good_condition(action)) continue;
+            const Action combo = Actions::combo_action[int(action)];
+            if (Actions::qim[int(action)] != 0) {
+                const double value = touch_value(action);
+                rates.touch_max = std::max(rates.touch_max, value);
+                if (combo == Action::None) { rates.reflect = std::max(rates.reflect, value); continue; }
+
+                double chain_value = 0, chain_cp = 0; // the action together with the combo leading up to it
+                for (Action a = action; a != Action::Null; a = Actions::combo_action[int(a)]) {
+                    if (Actions::qim[int(a)] != 0) chain_value += touch_value(a);
+                    chain_cp += Actions::cp_cost[int(a)];
+                }
+                rates.combo_max = std::max(rates.combo_max, chain_value);
+                rates.touch_per_cp = std::max(rates.touch_per_cp, chain_value / chain_cp);
+                if (Actions::dur_cost[int(action)] == 0) rates.touch_free_per_cp = std::max(rates.touch_free_per_cp, value / Actions::cp_cost[int(action)]);
+                else rates.touch_per_durability = std::max(rates.touch_per_durability, value / __min_durability_cost(action));
+            }
+            if (Actions::pim[int(action)] != 0) {
+                const double value = Actions::pim[int(action)];
+                if (combo == Action::None) { rates.muscle_memory = std::max(rates.muscle_memory, value); continue; }
+                rates.synth_max = std::max(rates.synth_max, value);
+                rates.synth_per_durability = std::max(rates.synth_per_durability, value / __min_durability_cost(action));
+            }
+        }
+        return rates;
+    }
+
+    // Manipulation lasts 2 steps longer when set under Primed, and Sturdy halves every cost once more
+    double __durability_budget(const State &state, const Rates &rates) {
+        const double per_cp = state.condition == Condition::Primed ? rates.primed_durability_per_cp : rates.durability_per_cp;
+        const double budget = state.durability + 5 * state.effects[int(Effect::Manipulation)] + per_cp * state.cp;
+        return state.condition == Condition::Sturdy ? 2 * budget : budget;
+    }
+
+    std::uint32_t __round_up(const double x) {
+        return x >= 4294967295.0 ? 4294967295u : std::uint32_t(std::ceil(x));
+    }
+
+    // upper bound on the quality any rotation starting at state can still add
+    std::uint32_t quality_upper_bound(const State &state) {
+        if (state.durability == 0) return 0;
+        const Rates &rates = __rates();
+        const double effect_qim = 1.00 + 10 * 0.10 + 1.0 + 0.5; // Inner Quiet 10, Great Strides, Innovation
+
+        double one_shot = 0; // actions only the current state may still be able to use
+        if (state.last_action == Action::None) one_shot += rates.reflect;
+        if (is_combo_action(state.last_action)) one_shot += rates.combo_max;
+        if (state.condition == Condition::Good || state.condition == Condition::Excellent) one_shot += rates.touch_max + Actions::qim[int(Action::PreciseTouch)];
+        const double by_cp = state.cp * rates.touch_per_cp;
+        const double by_durability = __durability_budget(state, rates) * rates.touch_per_durability + rates.touch_max
+                                   + state.cp * rates.touch_free_per_cp;
+        const double pending = 0.2 * Actions::recipe.base_quality_multiplier * state.effects[int(Effect::InnerQuiet)];
+        const double condition_qim = state.condition == Condition::Excellent ? 4.00 : state.condition == Condition::Good ? 1.50 : 1.00;
+        return __round_up(condition_qim * effect_qim * (pending + one_shot + std::min(by_cp, by_durability)));
+    }
+
+    // upper bound on the progress any rotation starting at state can still add
+    std::uint32_t progress_upper_bound(const State &state) {
+        if (state.durability == 0) return 0;
+        const Rates &rates = __rates();
+        const double effect_pim = 1.0 + 0.5; // Veneration, Muscle Memory is credited below
+
+        double one_shot = 0;
+        if (state.last_action == Action::None) one_shot += 2.0 * rates.muscle_memory + rates.synth_max;
+        else if (state.effects[int(Effect::MuscleMemory)] != 0) one_shot += rates.synth_max;
+        if (state.condition == Condition::Good || state.condition == Condition::Excellent) one_shot += Actions::pim[int(Action::IntensiveSynthesis)];
+        const double by_durability = __durability_budget(state, rates) * rates.synth_per_durability + rates.synth_max;
+        const double condition_pim = state.condition == Condition::Malleable ? 1.50 : 1.00;
+        return __round_up(condition_pim * effect_pim * (one_shot + by_durability));
+    }
+}
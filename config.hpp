@@ -9,4 +9,32 @@ namespace Config {
 
     const unsigned BASE_PROGRESS_MULTIPLIER = 237;
     const unsigned BASE_QUALITY_MULTIPLIER = 256;
-}
\ No newline at end of file
+}
+
+// Recipe and crafter parameters of a single craft, defaulting to the compile-time Config values.
+struct Recipe {
+    int max_cp = Config::MAX_CP;
+    int max_durability = Config::MAX_DURABILITY;
+
+    unsigned max_progress = Config::MAX_PROGRESS;
+    unsigned max_quality = Config::MAX_QUALITY;
+
+    unsigned base_progress_multiplier = Config::BASE_PROGRESS_MULTIPLIER;
+    unsigned base_quality_multiplier = Config::BASE_QUALITY_MULTIPLIER;
+
+    // largest max_cp and max_durability a packed State holds, state.hpp checks them against its layout
+    static constexpr int CP_LIMIT = (1 << 16) - 1, DURABILITY_LIMIT = (1 << 8) - 1;
+
+    constexpr bool in_range() const {
+        return 0 <= max_cp && max_cp <= CP_LIMIT && 0 <= max_durability && max_durability <= DURABILITY_LIMIT;
+    }
+
+    // memoized fronts only depend on these, recipes that agree on them can share one solve
+    bool same_action_table(const Recipe &other) const {
+        return max_durability == other.max_durability
+            && base_progress_multiplier == other.base_progress_multiplier
+            && base_quality_multiplier == other.base_quality_multiplier;
+    }
+
+    bool operator == (const Recipe &other) const = default;
+};
\ No newline at end of file
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "enums.hpp"
+#include "state.hpp"
+#include "actions.hpp"
+#include "pruning.hpp"
+#include "memo.hpp"
+#include "pareto.hpp"
+#include "solve.hpp"
+#include "config.hpp"
+
+// Probability of the condition of the next step given the condition of the current one,
+// as integer weights out of WEIGHT_ONE so that expected values stay exact fixed point.
+struct ConditionModel {
+    static constexpr std::uint32_t WEIGHT_ONE = 1 << 16;
+    std::array<std::array<std::uint32_t, int(Condition::COUNT)>, int(Condition::COUNT)> next{};
+
+    // every step stays Normal, the expected value solver then agrees with the deterministic one
+    static ConditionModel always_normal() {
+        ConditionModel model;
+        for (auto &row : model.next) row[int(Condition::Normal)] = WEIGHT_ONE;
+        return model;
+    }
+
+    // regular (non-expert) recipes: Normal rolls Good or Excellent, Excellent is always followed by Poor
+    static ConditionModel regular(const double good = 0.20, const double excellent = 0.04) {
+        ConditionModel model = always_normal();
+        auto &normal = model.next[int(Condition::Normal)];
+        normal[int(Condition::Good)] = std::uint32_t(good * WEIGHT_ONE);
+        normal[int(Condition::Excellent)] = std::uint32_t(excellent * WEIGHT_ONE);
+        normal[int(Condition::Normal)] = WEIGHT_ONE - normal[int(Condition::Good)] - normal[int(Condition::Excellent)];
+        model.next[int(Condition::Excellent)] = {};
+        model.next[int(Condition::Excellent)][int(Condition::Poor)] = WEIGHT_ONE;
+        return model;
+    }
+
+    bool valid() const {
+        for (const auto &row : next) {
+            std::uint64_t sum = 0;
+            for (const std::uint32_t weight : row) sum += weight;
+            if (sum != WEIGHT_ONE) return false;
+        }
+        return true;
+    }
+};
+
+// Maximizes expected quality over random conditions while still reaching progress in every outcome.
+//
+// The search alternates between decision nodes (condition known, pick an action) and chance nodes
+// (action taken, next condition not rolled yet). Only chance nodes are memoized: a decision front is
+// the Pareto merge of its children's chance fronts, and a chance front is the probability weighted
+// sum of the decision fronts of every condition that can follow. Both are stored as (progress,
+// expected quality) fronts in 64-bit entries, quality in fixed point with FRACTION_BITS bits.
+//
+// To keep the memo small, chance nodes are keyed on the first condition with the same transition
+// row as the one that was rolled, and progress is capped at the recipe's max_progress so fronts
+// never grow entries past the target. Once the memo outgrows memory_budget bytes the solve stops
+// and reports failure, fronts that were finished before that stay valid.
+class ExpectedSolver {
+    typedef std::uint64_t Entry;
+    typedef ParetoEntry<Entry> Traits;
+
+public:
+    static constexpr int FRACTION_BITS = 16;
+
+private:
+    static constexpr std::uint32_t BUDGET_CHECK_INTERVAL = 1 << 12; // inserts between memory checks
+
+    const ConditionModel model;
+    const std::size_t memory_budget;
+    std::array<Condition, int(Condition::COUNT)> canonical; // condition sharing the same transition row
+    StripedMemo<Entry> sav;
+    Recipe sav_recipe;
+    bool over_budget = false;
+    std::uint32_t inserts = 0;
+    std::uint32_t n = 0, m = 0;
+    std::vector<std::uint32_t> ind = std::vector<std::uint32_t>(1 << 12); // grown by __decide
+    std::vector<Entry> buf = std::vector<Entry>(1 << 20); // grown by __reserve, so never held across one
+
+    std::uint64_t __chance_key(State state) const {
+        state.condition = canonical[int(state.condition)];
+        return state.pack();
+    }
+
+    // grows buf to hold size entries
+    void __reserve(const std::size_t size) {
+        if (size > buf.size()) buf.resize(std::max(size, 2 * buf.size()));
+    }
+
+    // appends entries + inc to buf, entries past max_progress collapse into one capped entry
+    void __append(const Entry *entries, const std::uint32_t length, const Entry inc) {
+        __reserve(n + length);
+        const std::uint32_t cap = Actions::recipe.max_progress;
+        std::uint32_t i = 0;
+        Entry capped = 0;
+        for (; i != length; ++i) {
+            const Entry sum = Traits::add(entries[i], inc);
+            if (Traits::progress(sum) < cap) break;
+            capped = Traits::pack(cap, Traits::quality(sum)); // quality grows along the front, keep the last one
+        }
+        if (capped != 0) buf[n++] = capped;
+        for (; i != length; ++i) buf[n++] = Traits::add(entries[i], inc);
+    }
+
+    // Weighted sum of the k decision fronts buf[first[i], first[i] + length[i]), written to dst.
+    // For a progress target p every front contributes the best quality among its entries reaching p,
+    // so the breakpoints are the union of all progress values up to the smallest maximum.
+    std::uint32_t __expect(const std::uint32_t *first, const std::uint32_t *length, const std::uint32_t *weight, const int k, Entry *dst) const {
+        std::uint32_t target = Actions::recipe.max_progress, pos[int(Condition::COUNT)] = {};
+        for (int c = 0; c != k; ++c) {
+            if (length[c] == 0) return 0; // progress cannot be guaranteed in every outcome
+            target = std::min(target, Traits::progress(buf[first[c]]));
+        }
+        std::uint32_t out = 0;
+        std::uint64_t bar = 0; // quality of the last entry written plus one
+        while (true) {
+            std::uint64_t sum = 0;
+            std::uint32_t next = 0;
+            for (int c = 0; c != k; ++c) {
+                const Entry *front = buf.data() + first[c];
+                while (pos[c] + 1 != length[c] && Traits::progress(front[pos[c] + 1]) >= target) ++pos[c];
+                sum += std::uint64_t(weight[c]) * Traits::quality(front[pos[c]]);
+                if (pos[c] + 1 != length[c]) next = std::max(next, Traits::progress(front[pos[c] + 1]));
+            }
+            const std::uint64_t qual = sum / ConditionModel::WEIGHT_ONE;
+            if (qual + 1 > bar) {
+                dst[out++] = Traits::pack(target, qual);
+                bar = qual + 1;
+            }
+            if (next == 0) return out;
+            target = next;
+        }
+    }
+
+    // appends the front of decision node state to buf
+    void __decide(const State &state) {
+        const std::uint32_t sav_n = n, sav_m = m;
+        if (m + std::size(ALL_ACTIONS) + 1 > ind.size()) ind.resize(2 * ind.size()); // a segment per action and the closing bound
+        for (const Action action : ALL_ACTIONS) {
+            if (!state.can_use_action(action) || !should_use_action(state, action)) continue;
+            const State new_state = state.use_action(action);
+            const std::uint32_t prog = state.get_progress_potency(action);
+            const Entry inc = Traits::pack(prog, std::uint64_t(state.get_quality_potency(action)) << FRACTION_BITS);
+            const std::uint32_t start = n;
+            if (new_state.durability != 0) {
+                __chance(new_state);
+                if (over_budget) { n = sav_n; m = sav_m; return; }
+                sav.lookup(__chance_key(new_state), [&](const Entry *entries, const std::uint32_t length) { __append(entries, length, inc); });
+            } else if (prog != 0) { // finishing action
+                const Entry zero = Traits::pack(0, 0);
+                __append(&zero, 1, inc);
+            }
+            if (start != n) ind[m++] = start; // children may have used ind[m] while this segment was empty
+        }
+        if (m == sav_m) return;
+        ind[m] = n;
+        __reserve(2 * n - sav_n);
+        const std::uint32_t length = merge_pareto_fronts(buf.data(), ind.data() + sav_m, m - sav_m, buf.data() + n);
+        std::memmove(buf.data() + sav_n, buf.data() + n, length * sizeof(Entry));
+        n = sav_n + length;
+        m = sav_m;
+    }
+
+    // memoizes the front of chance node state, whose condition is the one its action was used in
+    void __chance(const State &state) {
+        const std::uint64_t key = __chance_key(state);
+        if (sav.contains(key)) return;
+
+        const std::uint32_t sav_n = n;
+        std::uint32_t first[int(Condition::COUNT)], length[int(Condition::COUNT)], weight[int(Condition::COUNT)];
+        int k = 0;
+        State rolled = state;
+        for (int c = 0; c != int(Condition::COUNT); ++c) {
+            if (model.next[int(state.condition)][c] == 0) continue;
+            rolled.condition = Condition(c);
+            first[k] = n;
+            __decide(rolled);
+            if (over_budget) { n = sav_n; return; }
+            length[k] = n - first[k];
+            weight[k++] = model.next[int(state.condition)][c];
+        }
+        __reserve(2 * n - sav_n); // every output entry takes the progress of a different input entry
+        const std::uint32_t length_out = __expect(first, length, weight, k, buf.data() + n);
+        sav.insert(key, buf.data() + n, length_out);
+        n = sav_n;
+
+        if (++inserts % BUDGET_CHECK_INTERVAL == 0 && sav.table_bytes() + sav.front_bytes() > memory_budget) over_budget = true;
+    }
+
+    // drops the memo if the recipe no longer matches the one it was built for
+    void __sync_recipe() {
+        if (sav_recipe.same_action_table(Actions::recipe) && sav_recipe.max_progress == Actions::recipe.max_progress) return;
+        sav.clear();
+        over_budget = false;
+        sav_recipe = Actions::recipe;
+    }
+
+    // front of decision node state as a fresh vector, empty if the solve ran out of memory
+    std::vector<Entry> __front(const State &state) {
+        __sync_recipe();
+        over_budget = false;
+        n = 0; m = 0;
+        __decide(state);
+        std::vector<Entry> front(buf.data(), buf.data() + n);
+        n = 0;
+        return front;
+    }
+
+public:
+    explicit ExpectedSolver(const ConditionModel &model = ConditionModel::regular(), const std::size_t memory_budget = std::size_t(4) << 30):
+        model(model),
+        memory_budget(memory_budget)
+    {
+        for (int c = 0; c != int(Condition::COUNT); ++c) {
+            canonical[c] = Condition(c);
+            for (int d = 0; d != c; ++d)
+                if (model.next[d] == model.next[c]) { canonical[c] = Condition(d); break; }
+        }
+    }
+
+    ExpectedSolver(const ExpectedSolver &) = delete;
+    ExpectedSolver &operator = (const ExpectedSolver &) = delete;
+
+    // Fills the memo for every chance node below state. Returns false if the memory budget ran out.
+    bool solve(const State &state) {
+        __front(state);
+        return !over_budget;
+    }
+
+    // Expected quality of the best policy from state that reaches min_prog whatever conditions are rolled,
+    // 0 if there is none, min_prog is above the recipe's max_progress or the memory budget ran out
+    double get_expected_quality(const State &state, const std::uint32_t min_prog) {
+        if (state.durability == 0 || min_prog > Actions::recipe.max_progress) return 0;
+        const std::vector<Entry> front = __front(state);
+        std::uint64_t qual = 0;
+        for (const Entry entry : front) // decreasing progress, increasing quality
+            if (Traits::progress(entry) >= min_prog) qual = Traits::quality(entry);
+        return double(qual) / (1 << FRACTION_BITS);
+    }
+
+    // action of the best policy in state, Null if min_prog cannot be guaranteed or is above max_progress
+    Action get_best_action(const State &state, const std::uint32_t min_prog) {
+        if (state.durability == 0 || min_prog > Actions::recipe.max_progress || !solve(state)) return Action::Null;
+        std::uint64_t best_qual = 0;
+        Action best_action = Action::Null;
+        for (const Action action : ALL_ACTIONS) {
+            if (!state.can_use_action(action) || !should_use_action(state, action)) continue;
+            const std::uint32_t prog = state.get_progress_potency(action);
+            const std::uint32_t remaining = prog > min_prog ? 0 : min_prog - prog;
+            std::uint64_t qual = std::uint64_t(state.get_quality_potency(action)) << FRACTION_BITS;
+            const State new_state = state.use_action(action);
+            if (new_state.durability == 0) {
+                if (prog < min_prog) continue;
+            } else {
+                bool reachable = false;
+                std::uint64_t rest = 0;
+                sav.lookup(__chance_key(new_state), [&](const Entry *entries, const std::uint32_t length) {
+                    for (std::uint32_t i = 0; i != length && Traits::progress(entries[i]) >= remaining; ++i) {
+                        rest = Traits::quality(entries[i]);
+                        reachable = true;
+                    }
+                });
+                if (!reachable) continue;
+                qual += rest;
+            }
+            if (qual + 1 > best_qual) { best_qual = qual + 1; best_action = action; }
+        }
+        return best_action;
+    }
+
+    MemoryUsage get_memory_usage() const {
+        MemoryUsage usage{sav.size(), 0, sav.table_bytes(), sav.front_bytes(), 0};
+        sav.for_each([&](std::uint64_t, const Entry *, const std::uint32_t length) { usage.entries += length; });
+        return usage;
+    }
+};
@@ -2,25 +2,132 @@
 #include <chrono>
 #include <array>
 #include <vector>
+#include <string>
 #include <unordered_map>
 #include <algorithm>
+#include <cstdlib>
 
 #include "enums.hpp"
 #include "state.hpp"
 #include "actions.hpp"
 #include "solve.hpp"
+#include "snapshot.hpp"
+#include "expected.hpp"
 #include "config.hpp"
 
-int main() {
-    Actions::init();
-    Solver solver;
+// Solves the Config recipe and prints the best rotation with memo statistics.
+//
+// usage: main [--threads N] [--snapshot PATH] [--bound] [--budget-mib N] [--dominance] [--canonical]
+//             [--layered] [--anytime-ms N] [--expected-mib N] [--verify]
+//
+//   --snapshot      warm start from PATH if it holds a usable memo, and save the memo there after
+//   --bound         prune with the upper bound from the root
+//   --budget-mib    memo budget, 0 for unlimited
+//   --layered       solve bottom up instead of depth first, ignored with a budget
+//   --dominance     reuse the fronts of states sandwiched in cp between equal ones, which only the
+//                   recursive engine does, so it is rejected together with --layered
+//   --anytime-ms    first print the best answer found within N ms, the exact solve goes on after
+//   --expected-mib  also solve the expected quality over random conditions with a memo budget of N
+//   --verify        only check canonicalization and the action masks it leans on
+
+struct Options {
+    unsigned threads = 1;
+    const char *snapshot_path = nullptr;
+    bool bound = false, dominance = false, canonical = false, layered = false, verify = false;
+    std::size_t budget_mib = 0;
+    long long anytime_ms = -1, expected_mib = -1; // -1 for off
+};
+
+// fills options from argv, returns false on an unknown flag or a flag without its value
+bool parse_options(const int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+        auto number = [&](auto &out) {
+            const char *text = value();
+            if (text == nullptr) return false;
+            char *end;
+            const long long parsed = std::strtoll(text, &end, 10);
+            if (*text == '\0' || *end != '\0' || parsed < 0) return false;
+            out = parsed;
+            return true;
+        };
+        bool ok = true;
+        if (flag == "--threads") ok = number(options.threads) && options.threads != 0;
+        else if (flag == "--snapshot") ok = (options.snapshot_path = value()) != nullptr;
+        else if (flag == "--bound") options.bound = true;
+        else if (flag == "--budget-mib") ok = number(options.budget_mib);
+        else if (flag == "--dominance") options.dominance = true;
+        else if (flag == "--canonical") options.canonical = true;
+        else if (flag == "--layered") options.layered = true;
+        else if (flag == "--anytime-ms") ok = number(options.anytime_ms);
+        else if (flag == "--expected-mib") ok = number(options.expected_mib);
+        else if (flag == "--verify") options.verify = true;
+        else ok = false;
+        if (!ok) {
+            std::cout << "Bad argument " << flag << ", see the usage at the top of main.cpp\n";
+            return false;
+        }
+    }
+    if (options.layered && options.dominance) { // the layered engine never has a memoized state above the one it solves
+        std::cout << "--dominance only applies to the recursive engine, drop --layered\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+    const Recipe recipe;
+    if (!Actions::init(recipe)) {
+        std::cout << "Recipe cp or durability out of range\n";
+        return 1;
+    }
+    const char *snapshot_path = options.snapshot_path;
+    Solver solver(options.threads, options.bound ? BoundMode::Root : BoundMode::Off, options.budget_mib << 20);
+    solver.set_dominance(options.dominance);
+    solver.set_canonical(options.canonical || options.verify);
+    solver.set_engine(options.layered ? Engine::Layered : Engine::Recursive);
+    if (options.verify) { // also checks the action masks the canonicalization rules lean on
+        const std::size_t mask_mismatches = ActionMask::verify();
+        std::cout << "Action masks: " << (mask_mismatches == 0 ? "ok" : std::to_string(mask_mismatches) + " actions allowed differently") << '\n';
+        const std::size_t mismatches = Solver::verify_canonicalization(State(recipe.max_cp, recipe.max_durability));
+        std::cout << "Canonicalization: " << (mismatches == 0 ? "ok" : std::to_string(mismatches) + " states with a different front") << '\n';
+        return mismatches == 0 && mask_mismatches == 0 ? 0 : 1;
+    }
+    if (snapshot_path != nullptr && !load_snapshot(solver, snapshot_path))
+        std::cout << "No usable snapshot at " << snapshot_path << ", solving from scratch\n";
+
+    State init = State(recipe.max_cp, recipe.max_durability);
+    if (options.anytime_ms >= 0) { // the exact solve goes on in the background
+        const auto start = std::chrono::steady_clock::now();
+        const AnytimeAnswer answer = solver.solve_anytime(init, recipe.max_progress, start + std::chrono::milliseconds(options.anytime_ms));
+        const auto took = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "Anytime (" << took.count() << "ms, " << (answer.exact ? "exact" : "coarse") << "): " << answer.quality;
+        for (const Action action : answer.rotation) std::cout << " >> " << Actions::display_name[int(action)];
+        std::cout << '\n';
+    }
 
     auto t1 = std::chrono::high_resolution_clock::now();
-    State init = State(Config::MAX_CP, Config::MAX_DURABILITY);
-    solver.get_best_action(init, Config::MAX_PROGRESS);
+    solver.get_best_action(init, recipe.max_progress);
     auto t2 = std::chrono::high_resolution_clock::now();
     auto dt = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
 
     std::cout << "Time: " << dt.count() << "ms\n";
+    if (snapshot_path != nullptr && !save_snapshot(solver, snapshot_path))
+        std::cout << "Could not write snapshot to " << snapshot_path << '\n';
     solver.print_debug_info(init);
+    if constexpr (SolverStats::ENABLED) solver.get_solver_stats().write_json(std::cout);
+
+    if (options.expected_mib >= 0) { // expected quality over random conditions
+        ExpectedSolver expected(ConditionModel::regular(), std::size_t(options.expected_mib) << 20);
+        t1 = std::chrono::high_resolution_clock::now();
+        const bool solved = expected.solve(init);
+        t2 = std::chrono::high_resolution_clock::now();
+        dt = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1);
+        if (!solved) std::cout << "Expected value solve ran out of memory after " << dt.count() << "ms\n";
+        else std::cout << "Expected quality: " << expected.get_expected_quality(init, recipe.max_progress)
+                       << " (" << expected.get_memory_usage().states << " chance states, " << dt.count() << "ms)\n";
+    }
 }
\ No newline at end of file
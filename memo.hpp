@@ -0,0 +1,536 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <memory>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <bit>
+#include <algorithm>
+
+// Open-addressing hash table keyed by State::pack().
+// The full 64-bit key is stored and compared, so distinct states can never alias.
+template<typename Value>
+class MemoTable {
+    static constexpr std::uint64_t EMPTY = ~std::uint64_t(0); // never produced by State::pack()
+
+    struct alignas(sizeof(std::uint64_t) + sizeof(Value) <= 16 ? 16 : 32) Slot {
+        std::uint64_t key;
+        Value value;
+    };
+
+    static constexpr std::size_t MIN_CAPACITY = 1 << 10;
+
+    std::vector<Slot> slots;
+    std::size_t count = 0;
+
+    static std::size_t __hash(std::uint64_t key) { // splitmix64 finalizer
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+        return key ^ (key >> 31);
+    }
+
+    std::size_t __find_slot(const std::uint64_t key) const {
+        const std::size_t mask = slots.size() - 1;
+        std::size_t i = __hash(key) & mask;
+        while (slots[i].key != key && slots[i].key != EMPTY) i = (i + 1) & mask;
+        return i;
+    }
+
+    void __grow() {
+        std::vector<Slot> old(slots.empty() ? MIN_CAPACITY : slots.size() * 2);
+        std::swap(old, slots);
+        for (Slot &slot : slots) slot.key = EMPTY;
+        for (Slot &slot : old)
+            if (slot.key != EMPTY) slots[__find_slot(slot.key)] = std::move(slot);
+    }
+
+public:
+    std::size_t size() const { return count; }
+    std::size_t capacity() const { return slots.size(); }
+    std::size_t bytes_used() const { return slots.size() * sizeof(Slot); }
+
+    // bytes_used() of a table that received count keys
+    static std::size_t bytes_for(const std::size_t count) {
+        std::size_t capacity = MIN_CAPACITY;
+        while (2 * count > capacity) capacity *= 2;
+        return capacity * sizeof(Slot);
+    }
+
+    // sizes an empty table for count keys, so that it takes them without growing
+    void reserve(const std::size_t keys) {
+        std::vector<Slot>(bytes_for(keys) / sizeof(Slot)).swap(slots);
+        for (Slot &slot : slots) slot.key = EMPTY;
+    }
+
+    // bytes_used() once one more key is inserted
+    std::size_t bytes_after_insert() const {
+        return std::max(bytes_used(), bytes_for(count + 1));
+    }
+
+    Value *find(const std::uint64_t key) {
+        if (slots.empty()) return nullptr;
+        Slot &slot = slots[__find_slot(key)];
+        return slot.key == key ? &slot.value : nullptr;
+    }
+
+    const Value *find(const std::uint64_t key) const {
+        return const_cast<MemoTable *>(this)->find(key);
+    }
+
+    // inserts value if key is not present yet, returns the stored value
+    Value &emplace(const std::uint64_t key, Value value) {
+        if (2 * (count + 1) > slots.size()) __grow(); // keep load factor at most 1/2
+        Slot &slot = slots[__find_slot(key)];
+        if (slot.key == EMPTY) {
+            slot.key = key;
+            slot.value = std::move(value);
+            ++count;
+        }
+        return slot.value;
+    }
+
+    template<typename F> void for_each(F f) const {
+        for (const Slot &slot : slots)
+            if (slot.key != EMPTY) f(slot.key, slot.value);
+    }
+
+    // Calls visit(key, value) on occupied slots in slot order, starting at slot hand and wrapping
+    // around, until it returns true. Returns the slot after the last one visited.
+    template<typename F> std::size_t sweep(std::size_t hand, F visit) {
+        if (count == 0) return 0;
+        for (std::size_t i = hand & (slots.size() - 1); ; i = (i + 1) & (slots.size() - 1))
+            if (slots[i].key != EMPTY && visit(slots[i].key, slots[i].value)) return i + 1;
+    }
+
+    void clear() {
+        std::vector<Slot>().swap(slots); // give the memory back
+        count = 0;
+    }
+};
+
+// Append-only storage for Pareto fronts. Fronts are laid out back to back in fixed-size slabs
+// and never straddle two slabs, so an offset stays valid for the lifetime of the arena.
+template<typename Entry>
+class FrontArena {
+    static constexpr int SLAB_BITS = 20;
+    static constexpr std::uint64_t SLAB_SIZE = std::uint64_t(1) << SLAB_BITS;
+
+    std::vector<std::unique_ptr<Entry[]>> slabs;
+    std::uint64_t end = 0; // offset of the next free entry
+
+public:
+    static constexpr std::uint64_t MAX_LENGTH = SLAB_SIZE;
+
+    const Entry *data(const std::uint64_t offset) const {
+        return slabs[offset >> SLAB_BITS].get() + (offset & (SLAB_SIZE - 1));
+    }
+
+    // copies [first, first + length) into the arena and returns its offset
+    std::uint64_t append(const Entry *first, const std::uint64_t length) {
+        if ((end & (SLAB_SIZE - 1)) + length > SLAB_SIZE) end = slabs.size() << SLAB_BITS; // skip to next slab
+        if ((end >> SLAB_BITS) == slabs.size()) slabs.emplace_back(new Entry[SLAB_SIZE]);
+        const std::uint64_t offset = end;
+        std::memcpy(slabs[offset >> SLAB_BITS].get() + (offset & (SLAB_SIZE - 1)), first, length * sizeof(Entry));
+        end += length;
+        return offset;
+    }
+
+    std::size_t bytes_used() const { return end * sizeof(Entry); }
+
+    // Starts refilling the arena from offset 0 with move_down(), keeping the slabs.
+    void rewind() { end = 0; }
+
+    // Moves [offset, offset + length) to the end of a rewound arena and returns its new offset. If
+    // fronts are moved in increasing order of offset, none ends up past where it was, so no front
+    // still to be moved is overwritten. Empty fronts go to offset 0, which shrink() keeps.
+    std::uint64_t move_down(const std::uint64_t offset, const std::uint64_t length) {
+        if (length == 0) return 0;
+        if ((end & (SLAB_SIZE - 1)) + length > SLAB_SIZE) end = (end | (SLAB_SIZE - 1)) + 1;
+        std::memmove(slabs[end >> SLAB_BITS].get() + (end & (SLAB_SIZE - 1)), data(offset), length * sizeof(Entry));
+        const std::uint64_t moved = end;
+        end += length;
+        return moved;
+    }
+
+    // frees the slabs past the end, but the first one, which empty fronts point into
+    void shrink() { slabs.resize(std::min<std::size_t>(slabs.size(), std::max<std::uint64_t>(1, (end + SLAB_SIZE - 1) >> SLAB_BITS))); }
+
+    void clear() {
+        slabs.clear();
+        end = 0;
+    }
+};
+
+// location of a memoized Pareto front inside a FrontArena, and its CLOCK state
+struct ParetoFront {
+    std::uint64_t offset : 37, clock : 2, evicted : 1, length : 24;
+};
+
+struct MemoStats {
+    std::uint64_t hits = 0, misses = 0; // lookups
+    std::uint64_t evictions = 0, compactions = 0;
+
+    double hit_rate() const { return hits + misses == 0 ? 0 : double(hits) / (hits + misses); }
+};
+
+// Thread-safe memo of Pareto fronts. Keys are spread over independently locked stripes,
+// each owning its own table and arena, so concurrent solvers rarely contend.
+// A TAGGED memo keeps one byte per entry next to the front (the action that produced it), in a
+// second arena that receives the same appends and therefore shares the front's offset.
+//
+// With a budget set, a stripe that would outgrow its share, counting the table growth an insert
+// triggers, evicts fronts until it is down to 3/4 of it with a table that has room for another
+// quarter of the survivors, so that the inserts between two evictions do not double the table.
+// Eviction is a CLOCK sweep: every front starts with as many lives as the cost its inserter gave
+// it (0 to 3), each lookup hit adds one, and the hand takes one per pass and evicts the front
+// once none are left. Survivors are then compacted to the front of the arena and slabs left empty
+// are freed.
+template<typename Entry, bool TAGGED = false>
+class StripedMemo {
+    static constexpr int STRIPE_BITS = 6;
+    static constexpr std::size_t ENTRY_BYTES = sizeof(Entry) + (TAGGED ? 1 : 0);
+
+    struct Stripe {
+        std::mutex mutex;
+        MemoTable<ParetoFront> table;
+        FrontArena<Entry> fronts;
+        FrontArena<std::uint8_t> tags; // unused unless TAGGED
+        MemoStats stats;
+        std::size_t hand = 0; // of the CLOCK sweep
+    };
+
+    std::unique_ptr<Stripe[]> stripes = std::make_unique<Stripe[]>(1 << STRIPE_BITS);
+    std::size_t stripe_budget = 0; // bytes, 0 for unlimited
+
+    Stripe &__stripe(const std::uint64_t key) const {
+        return stripes[(key * 0x9e3779b97f4a7c15ull) >> (64 - STRIPE_BITS)];
+    }
+
+    // bytes of stripe once a front of length entries is inserted, including the table growing
+    static std::size_t __bytes_after_insert(const Stripe &stripe, const std::uint32_t length) {
+        return stripe.table.bytes_after_insert() + stripe.fronts.bytes_used() + stripe.tags.bytes_used() + length * ENTRY_BYTES;
+    }
+
+    // evicts fronts of stripe until it fits in target bytes, caller holds the lock
+    static void __evict(Stripe &stripe, const std::size_t target) {
+        std::size_t survivors = stripe.table.size(), live = 0;
+        stripe.table.for_each([&](std::uint64_t, const ParetoFront &front) { live += front.length * ENTRY_BYTES; });
+        auto fits = [&] { return survivors == 0 || live + MemoTable<ParetoFront>::bytes_for(survivors + survivors / 4) <= target; };
+        if (!fits()) {
+            stripe.hand = stripe.table.sweep(stripe.hand, [&](std::uint64_t, ParetoFront &front) {
+                if (front.evicted) return false;
+                if (front.clock != 0) {
+                    --front.clock;
+                    return false;
+                }
+                front.evicted = 1;
+                --survivors;
+                live -= front.length * ENTRY_BYTES;
+                return fits();
+            });
+        }
+
+        // survivors are compacted in place, allocating fresh arenas instead fragments the heap
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> order; // (offset, key) of survivors
+        order.reserve(survivors);
+        stripe.table.for_each([&](const std::uint64_t key, const ParetoFront &front) {
+            if (front.evicted) ++stripe.stats.evictions;
+            else order.emplace_back(front.offset, key);
+        });
+        std::sort(order.begin(), order.end());
+        MemoTable<ParetoFront> table;
+        table.reserve(survivors + survivors / 4);
+        stripe.fronts.rewind();
+        stripe.tags.rewind();
+        for (const auto &[offset, key] : order) {
+            ParetoFront front = *stripe.table.find(key);
+            front.offset = stripe.fronts.move_down(offset, front.length);
+            if constexpr (TAGGED) stripe.tags.move_down(offset, front.length);
+            table.emplace(key, front);
+        }
+        stripe.fronts.shrink();
+        stripe.tags.shrink();
+        std::swap(stripe.table, table);
+        ++stripe.stats.compactions;
+    }
+
+public:
+    bool contains(const std::uint64_t key) const {
+        Stripe &stripe = __stripe(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        return stripe.table.find(key) != nullptr;
+    }
+
+    // bytes the memo may use, split evenly over the stripes, 0 for unlimited
+    void set_budget(const std::size_t bytes) { stripe_budget = bytes >> STRIPE_BITS; }
+    std::size_t budget() const { return stripe_budget << STRIPE_BITS; }
+
+    // calls f(entries, length) with the front stored for key, returns false if there is none
+    template<typename F> bool lookup(const std::uint64_t key, F f) const {
+        Stripe &stripe = __stripe(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        ParetoFront *front = stripe.table.find(key);
+        if (front == nullptr) { ++stripe.stats.misses; return false; }
+        ++stripe.stats.hits;
+        if (front->clock != 3) ++front->clock;
+        f(stripe.fronts.data(front->offset), std::uint32_t(front->length));
+        return true;
+    }
+
+    // calls f(entries, tags, length) with the front stored for key, returns false if there is none
+    template<typename F> bool lookup_tagged(const std::uint64_t key, F f) const {
+        static_assert(TAGGED);
+        Stripe &stripe = __stripe(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        ParetoFront *front = stripe.table.find(key);
+        if (front == nullptr) { ++stripe.stats.misses; return false; }
+        ++stripe.stats.hits;
+        if (front->clock != 3) ++front->clock;
+        f(stripe.fronts.data(front->offset), stripe.tags.data(front->offset), std::uint32_t(front->length));
+        return true;
+    }
+
+    // Stores a front for key unless another thread got there first, tags are required if TAGGED.
+    // cost (0 to 3) is how many eviction passes the front survives without being looked up.
+    void insert(const std::uint64_t key, const Entry *entries, const std::uint32_t length, const std::uint8_t *tags = nullptr, const int cost = 3) {
+        Stripe &stripe = __stripe(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        if (stripe.table.find(key) != nullptr) return;
+        if (stripe_budget != 0 && __bytes_after_insert(stripe, length) > stripe_budget) __evict(stripe, stripe_budget / 4 * 3);
+        stripe.table.emplace(key, ParetoFront{stripe.fronts.append(entries, length), std::uint64_t(cost), 0, length});
+        if constexpr (TAGGED) stripe.tags.append(tags, length);
+    }
+
+    // calls f(key, entries, length) for every stored front, must not run concurrently with insert
+    template<typename F> void for_each(F f) const {
+        for (int i = 0; i < 1 << STRIPE_BITS; ++i)
+            stripes[i].table.for_each([&](const std::uint64_t key, const ParetoFront &front) {
+                f(key, stripes[i].fronts.data(front.offset), std::uint32_t(front.length));
+            });
+    }
+
+    // calls f(key, entries, tags, length) for every stored front, must not run concurrently with insert
+    template<typename F> void for_each_tagged(F f) const {
+        static_assert(TAGGED);
+        for (int i = 0; i < 1 << STRIPE_BITS; ++i)
+            stripes[i].table.for_each([&](const std::uint64_t key, const ParetoFront &front) {
+                f(key, stripes[i].fronts.data(front.offset), stripes[i].tags.data(front.offset), std::uint32_t(front.length));
+            });
+    }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (int i = 0; i < 1 << STRIPE_BITS; ++i) total += stripes[i].table.size();
+        return total;
+    }
+
+    MemoStats stats() const {
+        MemoStats total;
+        for (int i = 0; i < 1 << STRIPE_BITS; ++i) {
+            total.hits += stripes[i].stats.hits;
+            total.misses += stripes[i].stats.misses;
+            total.evictions += stripes[i].stats.evictions;
+            total.compactions += stripes[i].stats.compactions;
+        }
+        return total;
+    }
+
+    std::size_t table_bytes() const {
+        std::size_t total = 0;
+        for (int i = 0; i < 1 << STRIPE_BITS; ++i) total += stripes[i].table.bytes_used();
+        return total;
+    }
+
+    std::size_t front_bytes() const {
+        std::size_t total = 0;
+        for (int i = 0; i < 1 << STRIPE_BITS; ++i) total += stripes[i].fronts.bytes_used() + stripes[i].tags.bytes_used();
+        return total;
+    }
+
+    void clear() {
+        for (int i = 0; i < 1 << STRIPE_BITS; ++i) {
+            stripes[i].table.clear();
+            stripes[i].fronts.clear();
+            stripes[i].tags.clear();
+        }
+    }
+};
+
+// Memoized cps of every state signature (its key without the cp bits), one bitset per signature,
+// so that the memoized states closest in cp to a given one are found without probing the memo.
+// Striped by signature like StripedMemo, a stripe widens its bitsets when a larger cp comes in.
+class SignatureIndex {
+    static constexpr int STRIPE_BITS = 6;
+
+    struct Stripe {
+        std::mutex mutex;
+        MemoTable<std::uint32_t> table; // signature -> its bitset is bits[i * words, (i + 1) * words)
+        std::vector<std::uint64_t> bits;
+        std::size_t words = 0;
+    };
+
+    std::unique_ptr<Stripe[]> stripes = std::make_unique<Stripe[]>(1 << STRIPE_BITS);
+
+    Stripe &__stripe(const std::uint64_t signature) const {
+        return stripes[(signature * 0x9e3779b97f4a7c15ull) >> (64 - STRIPE_BITS)];
+    }
+
+    static void __widen(Stripe &stripe, const std::size_t words) {
+        std::vector<std::uint64_t> bits(stripe.table.size() * words);
+        for (std::size_t i = 0; i != stripe.table.size(); ++i)
+            std::copy_n(stripe.bits.data() + i * stripe.words, stripe.words, bits.data() + i * words);
+        std::swap(stripe.bits, bits);
+        stripe.words = words;
+    }
+
+public:
+    void insert(const std::uint64_t signature, const std::uint16_t cp) {
+        Stripe &stripe = __stripe(signature);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        if (std::size_t(cp >> 6) >= stripe.words) __widen(stripe, (cp >> 6) + 1);
+        const std::uint32_t i = stripe.table.emplace(signature, std::uint32_t(stripe.table.size()));
+        if (stripe.bits.size() < (i + 1) * stripe.words) stripe.bits.resize((i + 1) * stripe.words);
+        stripe.bits[i * stripe.words + (cp >> 6)] |= std::uint64_t(1) << (cp & 63);
+    }
+
+    // for cps whose front is gone from the memo
+    void erase(const std::uint64_t signature, const std::uint16_t cp) {
+        Stripe &stripe = __stripe(signature);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        const std::uint32_t *i = stripe.table.find(signature);
+        if (i != nullptr && std::size_t(cp >> 6) < stripe.words)
+            stripe.bits[*i * stripe.words + (cp >> 6)] &= ~(std::uint64_t(1) << (cp & 63));
+    }
+
+    // the closest cps below and above cp, false unless both exist
+    bool neighbors(const std::uint64_t signature, const std::uint16_t cp, std::uint16_t &below, std::uint16_t &above) const {
+        Stripe &stripe = __stripe(signature);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        const std::uint32_t *i = stripe.table.find(signature);
+        const std::size_t word = cp >> 6;
+        if (i == nullptr || word >= stripe.words) return false;
+        const std::uint64_t *bits = stripe.bits.data() + *i * stripe.words;
+
+        std::uint64_t mask = bits[word] & ~((std::uint64_t(2) << (cp & 63)) - 1);
+        std::size_t w = word;
+        while (mask == 0 && ++w != stripe.words) mask = bits[w];
+        if (mask == 0) return false;
+        above = std::uint16_t(w * 64 + std::countr_zero(mask));
+
+        mask = bits[word] & ((std::uint64_t(1) << (cp & 63)) - 1);
+        w = word;
+        while (mask == 0 && w != 0) mask = bits[--w];
+        if (mask == 0) return false;
+        below = std::uint16_t(w * 64 + 63 - std::countl_zero(mask));
+        return true;
+    }
+
+    std::size_t bytes_used() const {
+        std::size_t total = 0;
+        for (int i = 0; i < 1 << STRIPE_BITS; ++i)
+            total += stripes[i].table.bytes_used() + stripes[i].bits.capacity() * sizeof(std::uint64_t);
+        return total;
+    }
+
+    void clear() {
+        for (int i = 0; i < 1 << STRIPE_BITS; ++i) {
+            stripes[i].table.clear();
+            std::vector<std::uint64_t>().swap(stripes[i].bits);
+            stripes[i].words = 0;
+        }
+    }
+};
+
+// Keys some worker of a parallel solve is solving, so that the others wait for its front instead of
+// solving it again. A worker only holds the keys on its current path, so every stripe stays short.
+class InFlight {
+    static constexpr int STRIPE_BITS = 6;
+
+    struct Stripe {
+        std::mutex mutex;
+        std::vector<std::uint64_t> keys;
+    };
+
+    std::unique_ptr<Stripe[]> stripes = std::make_unique<Stripe[]>(1 << STRIPE_BITS);
+
+    Stripe &__stripe(const std::uint64_t key) const {
+        return stripes[(key * 0x9e3779b97f4a7c15ull) >> (64 - STRIPE_BITS)];
+    }
+
+public:
+    // false if another worker holds key already
+    bool claim(const std::uint64_t key) {
+        Stripe &stripe = __stripe(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        if (std::find(stripe.keys.begin(), stripe.keys.end(), key) != stripe.keys.end()) return false;
+        stripe.keys.push_back(key);
+        return true;
+    }
+
+    void release(const std::uint64_t key) {
+        Stripe &stripe = __stripe(key);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        const auto iter = std::find(stripe.keys.begin(), stripe.keys.end(), key);
+        *iter = stripe.keys.back();
+        stripe.keys.pop_back();
+    }
+
+    // blocks until key is released
+    void wait(const std::uint64_t key) const {
+        Stripe &stripe = __stripe(key);
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(stripe.mutex);
+                if (std::find(stripe.keys.begin(), stripe.keys.end(), key) == stripe.keys.end()) return;
+            }
+            std::this_thread::yield();
+        }
+    }
+};
+
+// Read-only fronts sorted by key, such as those of a snapshot file (see snapshot.hpp). Lookups
+// binary search keys and hand out pointers into storage that owner keeps alive.
+// The front of keys[i] is entries[starts[i], starts[i + 1]), tags holds the action of every entry.
+template<typename Entry>
+struct SnapshotFronts {
+    std::shared_ptr<const void> owner;
+    const std::uint64_t *keys = nullptr, *starts = nullptr;
+    const Entry *entries = nullptr;
+    const std::uint8_t *tags = nullptr;
+    std::uint64_t states = 0;
+
+    std::size_t size() const { return states; }
+
+    // length of the longest front
+    std::uint32_t longest() const {
+        std::uint64_t longest = 0;
+        for (std::size_t i = 0; i != states; ++i) longest = std::max(longest, starts[i + 1] - starts[i]);
+        return std::uint32_t(longest);
+    }
+
+    // calls f(entries, length) with the front stored for key, returns false if there is none
+    template<typename F> bool lookup(const std::uint64_t key, F f) const {
+        return lookup_tagged(key, [&](const Entry *first, const std::uint8_t *, const std::uint32_t length) { f(first, length); });
+    }
+
+    // calls f(entries, tags, length) with the front stored for key, returns false if there is none
+    template<typename F> bool lookup_tagged(const std::uint64_t key, F f) const {
+        const std::uint64_t *iter = std::lower_bound(keys, keys + states, key);
+        if (iter == keys + states || *iter != key) return false;
+        const std::size_t i = iter - keys;
+        f(entries + starts[i], tags + starts[i], std::uint32_t(starts[i + 1] - starts[i]));
+        return true;
+    }
+
+    // calls f(key, entries, tags, length) for every front
+    template<typename F> void for_each_tagged(F f) const {
+        for (std::size_t i = 0; i != states; ++i)
+            f(keys[i], entries + starts[i], tags + starts[i], std::uint32_t(starts[i + 1] - starts[i]));
+    }
+
+    void clear() { *this = SnapshotFronts(); }
+};
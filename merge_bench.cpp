@@ -0,0 +1,142 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "enums.hpp"
+#include "state.hpp"
+#include "actions.hpp"
+#include "solve.hpp"
+#include "pareto.hpp"
+#include "config.hpp"
+
+// Micro-benchmark of the merge kernel. Solves the Config recipe with max_cp set to cp while
+// recording every stride-th merge, then replays the recorded segments through the old two-phase
+// kernel (merge_sort_pareto_fronts) and the single-pass one (merge_pareto_fronts). The full
+// Config cp needs more memory than most machines have, hence the smaller default.
+//
+// usage: merge_bench [--cp N] [--stride N] [--repetitions N]
+
+struct Options {
+    int cp = 300;
+    std::size_t stride = 16;
+    int repetitions = 5;
+};
+
+// fills options from argv, returns false on an unknown flag or a flag without its value
+bool parse_options(const int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        auto number = [&](auto &out) {
+            const char *text = i + 1 < argc ? argv[++i] : nullptr;
+            if (text == nullptr) return false;
+            char *end;
+            const long long parsed = std::strtoll(text, &end, 10);
+            if (*text == '\0' || *end != '\0' || parsed <= 0) return false;
+            out = parsed;
+            return true;
+        };
+        bool ok = true;
+        if (flag == "--cp") ok = number(options.cp);
+        else if (flag == "--stride") ok = number(options.stride);
+        else if (flag == "--repetitions") ok = number(options.repetitions);
+        else ok = false;
+        if (!ok) {
+            std::cout << "Bad argument " << flag << ", see the usage at the top of merge_bench.cpp\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+struct CapturedMerge {
+    std::vector<DefaultEntry> entries;
+    std::vector<std::uint32_t> bounds; // relative to entries, k + 1 values
+};
+
+std::vector<CapturedMerge> captured;
+std::size_t sample_stride = 16, merges_seen = 0;
+
+void capture(const DefaultEntry *buf, const std::uint32_t *bounds, const std::uint32_t k) {
+    if (merges_seen++ % sample_stride != 0) return;
+    CapturedMerge merge;
+    merge.entries.assign(buf + bounds[0], buf + bounds[k]);
+    for (std::uint32_t i = 0; i <= k; ++i) merge.bounds.push_back(bounds[i] - bounds[0]);
+    captured.push_back(std::move(merge));
+}
+
+template<typename T> T percentile(std::vector<T> values, const double p) {
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, std::size_t(p * values.size()))];
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+    sample_stride = options.stride;
+    const int repetitions = options.repetitions;
+
+    Recipe recipe;
+    recipe.max_cp = options.cp;
+    if (!Actions::init(recipe)) {
+        std::cout << "Recipe cp out of range\n";
+        return 1;
+    }
+    Solver solver;
+    Solver::merge_observer = capture;
+    solver.solve(State(recipe.max_cp, recipe.max_durability));
+    Solver::merge_observer = nullptr;
+
+    std::vector<std::uint32_t> ks, segment_sizes, merge_sizes;
+    std::size_t total_entries = 0;
+    for (const CapturedMerge &merge : captured) {
+        const std::uint32_t k = merge.bounds.size() - 1;
+        ks.push_back(k);
+        merge_sizes.push_back(merge.bounds[k]);
+        for (std::uint32_t i = 0; i != k; ++i) segment_sizes.push_back(merge.bounds[i + 1] - merge.bounds[i]);
+        total_entries += merge.bounds[k];
+    }
+    std::cout << "Captured " << captured.size() << " of " << merges_seen << " merges, " << total_entries << " entries\n";
+    for (const double p : {0.50, 0.90, 0.99, 1.00}) {
+        std::cout << "p" << int(p * 100) << ": segments " << percentile(ks, p)
+                  << ", segment size " << percentile(segment_sizes, p)
+                  << ", merge size " << percentile(merge_sizes, p) << '\n';
+    }
+
+    std::vector<DefaultEntry> work(2 * (1 << 16)), out(1 << 16);
+    std::vector<std::uint32_t> bounds(1 << 10);
+    double two_phase_ms = 1e18, single_pass_ms = 1e18;
+    std::size_t mismatches = 0, checksum = 0;
+    for (int rep = 0; rep < repetitions; ++rep) {
+        auto t1 = std::chrono::steady_clock::now();
+        for (const CapturedMerge &merge : captured) {
+            std::memcpy(work.data(), merge.entries.data(), merge.entries.size() * sizeof(DefaultEntry));
+            std::copy(merge.bounds.begin(), merge.bounds.end(), bounds.begin());
+            checksum += merge_sort_pareto_fronts(work.data(), bounds.data(), merge.bounds.size() - 1);
+        }
+        auto t2 = std::chrono::steady_clock::now();
+        for (const CapturedMerge &merge : captured) {
+            std::memcpy(work.data(), merge.entries.data(), merge.entries.size() * sizeof(DefaultEntry));
+            checksum += merge_pareto_fronts(work.data(), merge.bounds.data(), merge.bounds.size() - 1, out.data());
+        }
+        auto t3 = std::chrono::steady_clock::now();
+        two_phase_ms = std::min(two_phase_ms, std::chrono::duration<double, std::milli>(t2 - t1).count());
+        single_pass_ms = std::min(single_pass_ms, std::chrono::duration<double, std::milli>(t3 - t2).count());
+    }
+
+    for (const CapturedMerge &merge : captured) { // both kernels must agree entry for entry
+        std::memcpy(work.data(), merge.entries.data(), merge.entries.size() * sizeof(DefaultEntry));
+        std::copy(merge.bounds.begin(), merge.bounds.end(), bounds.begin());
+        const std::uint32_t length = merge_sort_pareto_fronts(work.data(), bounds.data(), merge.bounds.size() - 1);
+        const std::uint32_t merged = merge_pareto_fronts(merge.entries.data(), merge.bounds.data(), merge.bounds.size() - 1, out.data());
+        if (length != merged || std::memcmp(work.data(), out.data(), length * sizeof(DefaultEntry)) != 0) ++mismatches;
+    }
+
+    std::cout << "Two-phase:   " << two_phase_ms << "ms (" << two_phase_ms * 1e6 / total_entries << "ns per entry)\n";
+    std::cout << "Single-pass: " << single_pass_ms << "ms (" << single_pass_ms * 1e6 / total_entries << "ns per entry)\n";
+    std::cout << "Mismatches: " << mismatches << " (checksum " << checksum << ")\n";
+    return mismatches == 0 ? 0 : 1;
+}
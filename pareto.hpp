@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <algorithm>
+#include <cstring>
+
+#include "config.hpp"
+
+// Pareto front entries pack progress into the high half and quality into the low half of an
+// unsigned word, so sorting entries orders them by progress first and quality second.
+// Both halves saturate instead of wrapping around.
+template<typename Entry>
+struct ParetoEntry {
+    static_assert(std::is_unsigned_v<Entry> && sizeof(Entry) >= 4);
+
+    static constexpr int SHIFT = sizeof(Entry) * 4;
+    static constexpr Entry MASK = (Entry(1) << SHIFT) - 1;
+    static constexpr std::uint64_t MAX_VALUE = MASK; // largest progress or quality stored exactly
+
+    static Entry pack(const std::uint64_t prog, const std::uint64_t qual) {
+        return Entry(std::min<std::uint64_t>(prog, MASK)) << SHIFT | Entry(std::min<std::uint64_t>(qual, MASK));
+    }
+
+    static std::uint32_t progress(const Entry entry) { return std::uint32_t(entry >> SHIFT); }
+    static std::uint32_t quality(const Entry entry) { return std::uint32_t(entry & MASK); }
+
+    // entry + inc, with progress and quality added separately
+    static Entry add(const Entry entry, const Entry inc) {
+        const Entry sum = entry + inc;
+        if ((sum & MASK) >= (inc & MASK) && sum >= inc) [[likely]] return sum; // neither half carried out
+        const Entry prog = (entry >> SHIFT) + (inc >> SHIFT);
+        const Entry qual = (entry & MASK) + (inc & MASK);
+        return std::min(prog, MASK) << SHIFT | std::min(qual, MASK);
+    }
+
+    // whether fronts whose progress and quality never exceed these are stored exactly
+    static bool fits(const std::uint64_t max_prog, const std::uint64_t max_qual) {
+        return max_prog <= MAX_VALUE && max_qual <= MAX_VALUE;
+    }
+};
+
+// 32-bit entries (16-bit progress and quality) unless the compile-time recipe needs more
+using DefaultEntry = std::conditional_t<
+    Config::MAX_PROGRESS <= ParetoEntry<std::uint32_t>::MAX_VALUE && Config::MAX_QUALITY <= ParetoEntry<std::uint32_t>::MAX_VALUE,
+    std::uint32_t, std::uint64_t>;
+
+// Keeps the Pareto optimal entries of [first, first + length), which must be sorted in decreasing order.
+// Works in place and returns the new length.
+template<typename Entry>
+std::uint32_t build_pareto_front(Entry *first, const std::uint32_t length) {
+    if (length == 0) return 0;
+    std::uint32_t p = 0;
+    for (std::uint32_t i = 1; i != length; ++i)
+        if (ParetoEntry<Entry>::quality(first[i]) > ParetoEntry<Entry>::quality(first[p])) first[++p] = first[i];
+    return p + 1;
+}
+
+// default tagger of merge_pareto_fronts(), nothing is recorded
+struct NoTags {
+    void operator()(std::uint32_t, std::uint32_t) const {}
+};
+
+// Merges k decreasing segments src[bounds[i], bounds[i + 1]) into dst in a single pass and drops
+// dominated entries on the way out, returns the number of entries written.
+// Up to 8 segments the largest head is found by a linear scan, beyond that heads are kept in a
+// loser tree. Every entry has nonzero progress (each rotation ends in a progress action), so 0
+// marks an exhausted segment.
+// tag(out, segment) is called with the segment of every candidate written to dst[out], like dst[out]
+// itself it is overwritten if the candidate turns out to be dominated.
+template<typename Entry, typename Tagger = NoTags>
+std::uint32_t merge_pareto_fronts(const Entry *src, const std::uint32_t *bounds, const std::uint32_t k, Entry *dst, Tagger tag = Tagger()) {
+    typedef ParetoEntry<Entry> Traits;
+    std::uint32_t out = 0;
+    std::uint64_t bar = 0; // quality of the last entry written plus one
+    auto emit = [&](const Entry entry, const std::uint32_t segment) { // branch-free, dst[out] is scratch until out moves past it
+        const std::uint64_t qual = std::uint64_t(Traits::quality(entry)) + 1;
+        const bool keep = qual > bar;
+        dst[out] = entry;
+        tag(out, segment);
+        out += keep;
+        bar = keep ? qual : bar;
+    };
+
+    if (k == 1) {
+        for (std::uint32_t i = bounds[0]; i != bounds[1]; ++i) emit(src[i], 0);
+        return out;
+    }
+    if (k == 2) {
+        std::uint32_t l1 = bounds[0], l2 = bounds[1];
+        const std::uint32_t r1 = bounds[1], r2 = bounds[2];
+        while (l1 != r1 && l2 != r2) {
+            const Entry a = src[l1], b = src[l2];
+            const bool first = a > b;
+            emit(first ? a : b, !first);
+            l1 += first;
+            l2 += !first;
+        }
+        while (l1 != r1) emit(src[l1++], 0);
+        while (l2 != r2) emit(src[l2++], 1);
+        return out;
+    }
+
+    if (k <= 8) { // few segments: a branch-free scan over the heads beats maintaining a tree
+        std::uint32_t pos[8], end[8];
+        Entry head[8];
+        for (std::uint32_t i = 0; i != k; ++i) {
+            pos[i] = bounds[i];
+            end[i] = bounds[i + 1];
+            head[i] = pos[i] != end[i] ? src[pos[i]] : 0;
+        }
+        for (std::uint32_t t = bounds[k] - bounds[0]; t != 0; --t) {
+            std::uint32_t w = 0;
+            for (std::uint32_t i = 1; i != k; ++i) w = head[i] > head[w] ? i : w;
+            emit(head[w], w);
+            ++pos[w];
+            head[w] = pos[w] != end[w] ? src[pos[w]] : 0;
+        }
+        return out;
+    }
+
+    constexpr std::uint32_t MAX_K = 64;
+    std::uint32_t K = 1;
+    while (K < k) K <<= 1;
+    std::uint32_t pos[MAX_K], loser[MAX_K], winner[2 * MAX_K];
+    Entry head[MAX_K];
+    for (std::uint32_t i = 0; i != K; ++i) {
+        pos[i] = i < k ? bounds[i] : 0;
+        head[i] = i < k && bounds[i] != bounds[i + 1] ? src[bounds[i]] : 0;
+        winner[K + i] = i;
+    }
+    for (std::uint32_t node = K - 1; node != 0; --node) {
+        const std::uint32_t a = winner[2 * node], b = winner[2 * node + 1];
+        const bool first = head[a] >= head[b];
+        winner[node] = first ? a : b;
+        loser[node] = first ? b : a;
+    }
+
+    std::uint32_t w = winner[1];
+    for (std::uint32_t t = bounds[k] - bounds[0]; t != 0; --t) {
+        emit(head[w], w);
+        ++pos[w];
+        head[w] = pos[w] != bounds[w + 1] ? src[pos[w]] : 0;
+        Entry best = head[w];
+        for (std::uint32_t node = (K + w) >> 1; node != 0; node >>= 1) { // replay the path to the root without branches
+            const std::uint32_t challenger = loser[node];
+            const Entry value = head[challenger];
+            const bool swap = value > best;
+            loser[node] = swap ? w : challenger;
+            w = swap ? challenger : w;
+            best = swap ? value : best;
+        }
+    }
+    return out;
+}
+
+// The previous two-phase kernel, kept as a reference for merge_bench.cpp: repeated pairwise merges
+// of the k segments of first[0, bounds[k]), ping-ponging with the scratch space right behind them,
+// followed by build_pareto_front(). bounds is overwritten, returns the new length.
+template<typename Entry>
+std::uint32_t merge_sort_pareto_fronts(Entry *first, std::uint32_t *bounds, std::uint32_t k) {
+    const std::uint32_t n = bounds[k];
+    Entry *src = first, *dst = first + n;
+    for (std::uint32_t i; k != 1; k = i / 2) {
+        bounds[k] = n;
+        for (i = 0; i < k; i += 2) {
+            if (i + 2 <= k) { // merge 2 segments
+                std::uint32_t l1 = bounds[i], l2 = bounds[i + 1], p = l1;
+                const std::uint32_t r1 = l2, r2 = bounds[i + 2];
+                while (l1 != r1 && l2 != r2)
+                    if (src[l1] > src[l2]) dst[p++] = src[l1++];
+                    else dst[p++] = src[l2++];
+                if (l1 != r1) std::memcpy(dst + p, src + l1, (r1 - l1) * sizeof(Entry));
+                if (l2 != r2) std::memcpy(dst + p, src + l2, (r2 - l2) * sizeof(Entry));
+            } else { // copy 1 segment
+                std::memcpy(dst + bounds[i], src + bounds[i], (bounds[i + 1] - bounds[i]) * sizeof(Entry));
+            }
+            bounds[i / 2] = bounds[i]; // write back beginning index of merged segment
+        }
+        std::swap(src, dst);
+    }
+    if (src != first) std::memcpy(first, src, n * sizeof(Entry)); // odd #iterations
+    return build_pareto_front(first, n);
+}
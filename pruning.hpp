@@ -1,9 +1,16 @@
 #pragma once
 
+#include <array>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+
 #include "state.hpp"
 #include "actions.hpp"
+#include "config.hpp"
 
-bool should_use_action(const State &state, const Action action) {
+template<Action action> bool should_use_action(const State &state) {
     if (state.last_action == Action::Observe) {
         if (action != Action::FocusedSynthesis && action != Action::FocusedTouch) return false;
     } else if (state.last_action == Action::None) {
@@ -43,11 +50,227 @@ bool should_use_action(const State &state, const Action action) {
                 && state.effects[int(Effect::MuscleMemory)] == 0
                 && state.effects[int(Effect::Veneration)] <= 2;
         case Action::MasterMend:
-            return state.durability + 30 <= Config::MAX_DURABILITY;
+            return state.durability + 30 <= Actions::recipe.max_durability;
         case Action::BasicTouch:
         case Action::StandardTouch:
             return state.last_action != Action::StandardTouch;
         default:
             return true;
     }
-}
\ No newline at end of file
+}
+
+bool should_use_action(const State &state, const Action action) {
+    static constexpr auto table = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<bool (*)(const State &), sizeof...(I)>{&should_use_action<Action(I)>...};
+    }(std::make_index_sequence<int(Action::COUNT)>());
+    return table[int(action)](state);
+}
+
+// Allowed actions of a state, can_use_action() && should_use_action(), as a bitmask where bit i
+// stands for ALL_ACTIONS[i]. Apart from cp and durability, every check either looks at last_action
+// or at the effects and condition, so the mask is the AND of a table for each: by_last_action, and
+// by_effects keyed on the few thresholds the checks use. Pruning has to stay in that shape, and any
+// change to it has to be checked with ActionMask::verify().
+namespace ActionMask {
+    typedef std::uint32_t Mask;
+    static_assert(std::size(ALL_ACTIONS) <= 32);
+
+    constexpr int SIGNATURE_BITS = 11;
+
+    struct Tables {
+        Recipe recipe;
+        bool valid = false;
+        std::array<Mask, int(Action::COUNT)> by_last_action;
+        std::array<Mask, 1 << SIGNATURE_BITS> by_effects;
+        std::vector<Mask> by_cp; // actions affordable with cp, the last entry covers any cp above
+        Mask master_mend = 0, groundwork = 0;
+    };
+
+    constexpr Mask __bit(const Action action) {
+        for (std::size_t i = 0; i != std::size(ALL_ACTIONS); ++i)
+            if (ALL_ACTIONS[i] == action) return Mask(1) << i;
+        return 0;
+    }
+
+    // classes of the effect values: Inner Quiet 0 / 1-5 / 6-9 / 10, Veneration 0-1 / 2 / 3+, Innovation 0 / 1 / 2 / 3+
+    int __signature(const State &state) {
+        const int iq = state.effects[int(Effect::InnerQuiet)], veneration = state.effects[int(Effect::Veneration)];
+        const int innovation = state.effects[int(Effect::Innovation)];
+        return (state.condition == Condition::Good || state.condition == Condition::Excellent)
+             | (state.effects[int(Effect::MuscleMemory)] != 0) << 1
+             | (state.effects[int(Effect::GreatStrides)] != 0) << 2
+             | (state.effects[int(Effect::WasteNot)] != 0) << 3
+             | (state.effects[int(Effect::Manipulation)] != 0) << 4
+             | (iq == 0 ? 0 : iq < 6 ? 1 : iq < 10 ? 2 : 3) << 5
+             | std::min(std::max(veneration - 1, 0), 2) << 7
+             | std::min(innovation, 3) << 9;
+    }
+
+    // a state of signature, every state of it allows the same actions apart from cp and durability
+    State __representative(const int signature, const Action last_action) {
+        State state(1 << 15, 1);
+        state.condition = signature & 1 ? Condition::Good : Condition::Normal;
+        state.effects[int(Effect::MuscleMemory)] = signature >> 1 & 1;
+        state.effects[int(Effect::GreatStrides)] = signature >> 2 & 1;
+        state.effects[int(Effect::WasteNot)] = signature >> 3 & 1;
+        state.effects[int(Effect::Manipulation)] = signature >> 4 & 1;
+        state.effects[int(Effect::InnerQuiet)] = std::array{0, 1, 6, 10}[signature >> 5 & 3];
+        state.effects[int(Effect::Veneration)] = std::array{0, 2, 3, 3}[signature >> 7 & 3];
+        state.effects[int(Effect::Innovation)] = signature >> 9 & 3;
+        state.last_action = last_action;
+        return state;
+    }
+
+    bool __allowed(State state, const Action action) {
+        // durability is checked apart, pick one that passes Groundwork and Master's Mend
+        state.durability = action == Action::MasterMend ? 1 : (1 << State::DURABILITY_BITS) - 1;
+        return state.can_use_action(action) && should_use_action(state, action);
+    }
+
+    const Tables &__tables() {
+        static thread_local Tables tables;
+        if (tables.valid && tables.recipe.same_action_table(Actions::recipe)) return tables;
+        tables = Tables();
+        tables.recipe = Actions::recipe;
+        tables.valid = true;
+        // effects of each action are checked with the combo it needs, and last_action with any effects that allow it
+        for (int signature = 0; signature != 1 << SIGNATURE_BITS; ++signature) {
+            tables.by_effects[signature] = 0;
+            for (std::size_t i = 0; i != std::size(ALL_ACTIONS); ++i) {
+                const Action action = ALL_ACTIONS[i];
+                const Action combo = Actions::combo_action[int(action)];
+                if (__allowed(__representative(signature, combo), action))
+                    tables.by_effects[signature] |= Mask(1) << i;
+            }
+        }
+        for (int last = 0; last != int(Action::COUNT); ++last) {
+            tables.by_last_action[last] = 0;
+            for (std::size_t i = 0; i != std::size(ALL_ACTIONS); ++i) {
+                int signature = 0;
+                while (signature != 1 << SIGNATURE_BITS && !(tables.by_effects[signature] >> i & 1)) ++signature;
+                if (signature != 1 << SIGNATURE_BITS && __allowed(__representative(signature, Action(last)), ALL_ACTIONS[i]))
+                    tables.by_last_action[last] |= Mask(1) << i;
+            }
+        }
+        int max_cost = 0;
+        for (const Action action : ALL_ACTIONS) max_cost = std::max(max_cost, Actions::cp_cost[int(action)]);
+        tables.by_cp.assign(max_cost + 1, 0);
+        for (int cp = 0; cp <= max_cost; ++cp)
+            for (std::size_t i = 0; i != std::size(ALL_ACTIONS); ++i)
+                if (Actions::cp_cost[int(ALL_ACTIONS[i])] <= cp) tables.by_cp[cp] |= Mask(1) << i;
+        tables.master_mend = __bit(Action::MasterMend);
+        tables.groundwork = __bit(Action::Groundwork);
+        return tables;
+    }
+
+    Mask allowed(const State &state) {
+        if (state.durability <= 0) return 0;
+        const Tables &tables = __tables();
+        Mask mask = tables.by_last_action[int(state.last_action)] & tables.by_effects[__signature(state)]
+                  & tables.by_cp[std::min<std::size_t>(state.cp, tables.by_cp.size() - 1)];
+        if (state.durability + 30 > Actions::recipe.max_durability) mask &= ~tables.master_mend;
+        if (state.durability < state.get_durability_cost(Action::Groundwork)) mask &= ~tables.groundwork;
+        return mask;
+    }
+
+    // Number of actions where allowed() disagrees with the checks it replaces, over samples states
+    // drawn from every last_action, condition and effect value, and cp and durability around the costs.
+    std::size_t verify(const std::size_t samples = 1 << 20) {
+        std::size_t mismatches = 0;
+        const int max_cost = int(__tables().by_cp.size()) - 1;
+        std::uint64_t seed = 0x2545f4914f6cdd1dull;
+        auto next = [&](const int bound) { // splitmix64
+            std::uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return int((z ^ (z >> 31)) % std::uint64_t(bound));
+        };
+        for (std::size_t k = 0; k != samples; ++k) {
+            State state(next(max_cost + 2), next(Actions::recipe.max_durability + 1));
+            for (int effect = 0; effect != int(Effect::COUNT); ++effect) state.effects[effect] = next(11);
+            state.condition = Condition(next(int(Condition::COUNT)));
+            state.last_action = Action(next(int(Action::COUNT)));
+            const Mask mask = allowed(state);
+            for (std::size_t i = 0; i != std::size(ALL_ACTIONS); ++i)
+                mismatches += bool(mask >> i & 1) != (state.can_use_action(ALL_ACTIONS[i]) && should_use_action(state, ALL_ACTIONS[i]));
+        }
+        return mismatches;
+    }
+}
+
+// Canonical representatives of states that have the same front. A front only gets entries from
+// actions that end the craft with progress, and pruning above forbids pure progress actions while
+// Inner Quiet is up, so the rules below follow should_use_action() and can_use_action() closely.
+// They assume the condition never changes, as in ParetoSolver. Any change to the pruning has to be
+// checked with ParetoSolver::verify_canonicalization().
+namespace Canonical {
+    template<typename P> constexpr int __min_cp_cost(P pred) {
+        int cost = 1 << 16;
+        for (const ActionInfo &info : Actions::INFO)
+            if (info.action != Action::Null && info.action != Action::None && pred(info)) cost = std::min(cost, info.cp_cost);
+        return cost;
+    }
+
+    constexpr bool __good_only(const Action action) {
+        return action == Action::PreciseTouch || action == Action::IntensiveSynthesis;
+    }
+
+    // cheapest action gaining quality, other than openers and actions only usable in Good / Excellent
+    constexpr int TOUCH_CP = __min_cp_cost([](const ActionInfo &info) {
+        return info.quality_percent != 0 && info.combo_action != Action::None && !__good_only(info.action);
+    });
+    // cheapest action making progress while Inner Quiet is up, with or without Good / Excellent only actions
+    constexpr int MIXED_CP = __min_cp_cost([](const ActionInfo &info) {
+        return info.quality_percent != 0 && info.progress_percent != 0 && info.combo_action != Action::None && !__good_only(info.action);
+    });
+    constexpr int GOOD_MIXED_CP = __min_cp_cost([](const ActionInfo &info) {
+        return info.quality_percent != 0 && info.progress_percent != 0 && info.combo_action != Action::None;
+    });
+    constexpr int OPENER_CP = __min_cp_cost([](const ActionInfo &info) { return info.combo_action == Action::None; });
+    constexpr int AFTER_OBSERVE_CP = __min_cp_cost([](const ActionInfo &info) { return info.combo_action == Action::Observe; });
+    static_assert(TOUCH_CP <= Actions::cp_cost[int(Action::Innovation)] && TOUCH_CP <= Actions::cp_cost[int(Action::Veneration)]
+        && TOUCH_CP <= Actions::cp_cost[int(Action::ByregotsBlessing)], "Innovation has to stop mattering with the touches");
+    static_assert(Actions::cp_cost[int(Action::PreparatoryTouch)] >= 2 * TOUCH_CP, "stacks of Inner Quiet cost TOUCH_CP at least");
+
+    // True if no allowed sequence of actions ends the craft with progress, the front is empty then.
+    // With Inner Quiet up, progress needs an action gaining both or Byregot's Blessing to reset it
+    // first, which in turn needs 6 stacks and Innovation or Great Strides.
+    bool is_dead(const State &state) {
+        const bool good = state.condition == Condition::Good || state.condition == Condition::Excellent;
+        const int inner_quiet = state.effects[int(Effect::InnerQuiet)];
+        if (inner_quiet != 0 && state.last_action != Action::None) {
+            if (good) {
+                if (state.cp < GOOD_MIXED_CP) return true; // Precise Touch gains stacks for less than TOUCH_CP
+            } else {
+                int byregot = Actions::cp_cost[int(Action::ByregotsBlessing)] + TOUCH_CP * std::max(0, 6 - inner_quiet);
+                if (state.effects[int(Effect::Innovation)] == 0 && state.effects[int(Effect::GreatStrides)] == 0)
+                    byregot += Actions::cp_cost[int(Action::Innovation)];
+                if (state.cp < std::min(MIXED_CP, byregot)) return true;
+            }
+        }
+        if (state.effects[int(Effect::GreatStrides)] != 0 && state.cp < Actions::cp_cost[int(Action::ByregotsBlessing)]) return true;
+        if (state.last_action == Action::Observe && state.cp < AFTER_OBSERVE_CP) return true;
+        if (state.last_action == Action::None && state.cp < OPENER_CP) return true;
+        return false;
+    }
+}
+
+// Representative of the states sharing state's front:
+// - dead states (see Canonical::is_dead) all map to one state
+// - Basic / Standard Touch as last action only matter for the touches they combo into or prune
+// - Innovation does not matter once no touch, Innovation, Veneration or Byregot's is affordable
+State canonicalize(State state) {
+    if (Canonical::is_dead(state)) {
+        State dead(0, 1);
+        dead.effects[int(Effect::InnerQuiet)] = 1;
+        dead.last_action = Action::Null;
+        return dead;
+    }
+    const bool touch_affordable = state.cp >= Canonical::TOUCH_CP;
+    if (state.last_action == Action::BasicTouch || state.last_action == Action::StandardTouch)
+        if (!touch_affordable || state.effects[int(Effect::GreatStrides)] != 0 || state.effects[int(Effect::MuscleMemory)] != 0)
+            state.last_action = Action::Null;
+    if (!touch_affordable && state.last_action != Action::None && state.condition != Condition::Good && state.condition != Condition::Excellent)
+        state.effects[int(Effect::Innovation)] = 0;
+    return state;
+}
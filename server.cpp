@@ -0,0 +1,446 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+#include <cctype>
+#include <cstdlib>
+#include <csignal>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "enums.hpp"
+#include "state.hpp"
+#include "actions.hpp"
+#include "solve.hpp"
+#include "thread_pool.hpp"
+#include "config.hpp"
+
+// Resident solver that keeps its memo warm between requests. Reads one JSON request per line from
+// stdin, or from every client of a Unix socket, and writes one JSON line per request back:
+//
+//   {"id": 7, "recipe": {"max_cp": 600, "max_progress": 5000}, "state": {"cp": 420, "durability": 45, "inner_quiet": 3}, "min_progress": 5000}
+//   {"id": 7, "quality": 6210, "rotation": ["Prudent Touch", ...], "cached": false, "batched": 1, "queue_us": 35, "solve_us": 81240}
+//
+// id is a number or a string and is echoed back. Recipe fields are those of Recipe and default to Config. The state defaults to the recipe's
+// initial state, its fields are cp, durability, condition, last_action (enum values) and one per
+// effect, cp and durability at most the recipe's and effects at most State::MAX_EFFECTS. min_progress
+// defaults to max_progress. With min_quality, the answer is the first rotation
+// found that reaches it (see ParetoSolver::find_rotation), quality is that rotation's and reached
+// tells whether there is one at all.
+//
+// The action tables are global, so pending requests are answered in batches of one recipe, the
+// oldest first. Identical requests in a batch are solved once, distinct ones on a pool of solvers
+// sharing one memo. The memo is kept across batches of recipes with the same action table.
+// cached tells whether the state was memoized before its batch started, batched how many requests
+// shared its solve.
+//
+// usage: server [--threads N] [--socket PATH] [--budget-mib N]
+//
+//   --socket      serve the clients of a Unix socket at PATH instead of stdin
+//   --budget-mib  memo budget, 0 for unlimited
+
+typedef std::chrono::steady_clock Clock;
+
+const char *const EFFECT_NAMES[] = {"inner_quiet", "waste_not", "innovation", "veneration", "great_strides", "muscle_memory", "manipulation"};
+static_assert(std::size(EFFECT_NAMES) == int(Effect::COUNT));
+
+// Flattens a JSON object of numbers, strings and nested objects into dotted keys, for example
+// {"recipe": {"max_cp": 600}} gives "recipe.max_cp" -> "600" and "recipe" -> "{}". Strings keep their quotes.
+bool parse_object(const std::string &line, std::size_t &i, const std::string &prefix, std::map<std::string, std::string> &fields) {
+    auto skip = [&] { while (i < line.size() && std::isspace((unsigned char)line[i])) ++i; };
+    auto string = [&](std::string &out) {
+        if (i >= line.size() || line[i] != '"') return false;
+        const std::size_t first = i++;
+        while (i < line.size() && line[i] != '"') i += line[i] == '\\' ? 2 : 1;
+        if (i >= line.size()) return false;
+        out = line.substr(first, ++i - first);
+        return true;
+    };
+    skip();
+    if (i >= line.size() || line[i++] != '{') return false;
+    skip();
+    if (i < line.size() && line[i] == '}') { ++i; return true; }
+    while (true) {
+        std::string key;
+        skip();
+        if (!string(key)) return false;
+        key = prefix + key.substr(1, key.size() - 2);
+        skip();
+        if (i >= line.size() || line[i++] != ':') return false;
+        skip();
+        if (i < line.size() && line[i] == '{') {
+            fields[key] = "{}";
+            if (!parse_object(line, i, key + '.', fields)) return false;
+        } else if (i < line.size() && line[i] == '"') {
+            if (!string(fields[key])) return false;
+        } else {
+            const std::size_t first = i;
+            while (i < line.size() && (std::isalnum((unsigned char)line[i]) || line[i] == '-' || line[i] == '+' || line[i] == '.')) ++i;
+            if (first == i) return false;
+            fields[key] = line.substr(first, i - first);
+        }
+        skip();
+        if (i < line.size() && line[i] == ',') { ++i; continue; }
+        if (i < line.size() && line[i] == '}') { ++i; return true; }
+        return false;
+    }
+}
+
+// true if token is a JSON number, -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+bool is_json_number(const std::string &token) {
+    std::size_t i = 0;
+    auto digits = [&] {
+        const std::size_t first = i;
+        while (i < token.size() && std::isdigit((unsigned char)token[i])) ++i;
+        return i != first;
+    };
+    if (i < token.size() && token[i] == '-') ++i;
+    if (i < token.size() && token[i] == '0') ++i;
+    else if (!digits()) return false;
+    if (i < token.size() && token[i] == '.' && (++i, !digits())) return false;
+    if (i < token.size() && (token[i] == 'e' || token[i] == 'E')) {
+        ++i;
+        if (i < token.size() && (token[i] == '+' || token[i] == '-')) ++i;
+        if (!digits()) return false;
+    }
+    return i == token.size();
+}
+
+// where the answers to a client's requests go, closed once its reader and last request are done
+struct Client {
+    const int fd;
+    std::mutex mutex;
+
+    explicit Client(const int fd): fd(fd) {}
+    ~Client() { if (fd > 2) close(fd); }
+
+    void send(const std::string &line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t done = 0; done < line.size(); ) {
+            const ssize_t written = write(fd, line.data() + done, line.size() - done);
+            if (written <= 0) return; // client went away
+            done += written;
+        }
+    }
+};
+
+struct Request {
+    std::string id; // raw JSON token, echoed back
+    Recipe recipe;
+    State state = State(0, 0);
+    std::uint32_t min_progress = 0;
+    std::uint32_t min_quality = 0;
+    bool threshold = false; // min_quality was given
+    std::shared_ptr<Client> client;
+    Clock::time_point arrival;
+};
+
+// fills request from one line, returns false with error set if it is malformed
+bool parse_request(const std::string &line, Request &request, std::string &error) {
+    std::map<std::string, std::string> fields;
+    std::size_t i = 0;
+    if (!parse_object(line, i, "", fields)) {
+        error = "malformed JSON";
+        return false;
+    }
+    const auto id = fields.find("id");
+    if (id != fields.end()) { // echoed back, so only a number or a string
+        if (id->second.front() != '"' && !is_json_number(id->second)) {
+            error = "id must be a number or a string";
+            return false;
+        }
+        request.id = id->second;
+    }
+    auto number = [&](const std::string &key, auto &value, const long long limit) {
+        const auto it = fields.find(key);
+        if (it == fields.end()) return true; // keep the default
+        char *end;
+        const long long parsed = std::strtoll(it->second.c_str(), &end, 10);
+        if (it->second.empty() || *end != '\0' || parsed < 0 || parsed > limit) {
+            error = "bad value for " + key;
+            return false;
+        }
+        value = std::remove_reference_t<decltype(value)>(parsed);
+        return true;
+    };
+
+    Recipe &recipe = request.recipe;
+    if (!number("recipe.max_cp", recipe.max_cp, Recipe::CP_LIMIT)
+        || !number("recipe.max_durability", recipe.max_durability, Recipe::DURABILITY_LIMIT)
+        || !number("recipe.max_progress", recipe.max_progress, 0xffff)
+        || !number("recipe.max_quality", recipe.max_quality, 0xffff)
+        || !number("recipe.base_progress_multiplier", recipe.base_progress_multiplier, 0xffff)
+        || !number("recipe.base_quality_multiplier", recipe.base_quality_multiplier, 0xffff))
+        return false;
+
+    State &state = request.state;
+    state = State(recipe.max_cp, recipe.max_durability);
+    int condition = int(Condition::Normal), last_action = int(Action::None);
+    if (!number("state.cp", state.cp, recipe.max_cp)
+        || !number("state.durability", state.durability, recipe.max_durability)
+        || !number("state.condition", condition, int(Condition::COUNT) - 1)
+        || !number("state.last_action", last_action, int(Action::COUNT) - 1))
+        return false;
+    state.condition = Condition(condition);
+    state.last_action = Action(last_action);
+    for (int effect = 0; effect != int(Effect::COUNT); ++effect)
+        if (!number(std::string("state.") + EFFECT_NAMES[effect], state.effects[effect], State::MAX_EFFECTS[effect])) return false;
+
+    request.min_progress = recipe.max_progress;
+    request.threshold = fields.count("min_quality") != 0;
+    return number("min_progress", request.min_progress, 0xffff) && number("min_quality", request.min_quality, 0xffff);
+}
+
+class SolverServer {
+    // identical requests of a batch, answered by one solve
+    struct Job {
+        State state = State(0, 0);
+        std::uint32_t min_progress, min_quality;
+        bool threshold;
+        bool cached;
+        std::vector<const Request *> requests;
+    };
+
+    Solver solver; // answers batches with a single job, using every thread for the solve
+    std::vector<std::unique_ptr<Solver>> workers; // share solver's memo, one per pool thread
+    WorkStealingPool pool;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Request> pending;
+    unsigned readers = 0; // sources that can still send requests
+
+    std::atomic<std::uint64_t> answered{0}, solved{0}, from_memo{0}, latency_us{0}, max_latency_us{0};
+
+    void __submit(const std::string &line, const std::shared_ptr<Client> &client) {
+        if (std::all_of(line.begin(), line.end(), [](const char c) { return std::isspace((unsigned char)c); })) return;
+        Request request;
+        request.id = "null";
+        std::string error;
+        if (!parse_request(line, request, error)) {
+            client->send("{\"id\": " + request.id + ", \"error\": \"" + error + "\"}\n");
+            return;
+        }
+        request.client = client;
+        request.arrival = Clock::now();
+        { std::lock_guard<std::mutex> lock(mutex); pending.push_back(std::move(request)); }
+        ready.notify_one();
+    }
+
+    // queues every line read from fd until it is closed, answers go to client
+    void __read(const int fd, std::shared_ptr<Client> client) {
+        std::string line;
+        char chunk[1 << 12];
+        for (ssize_t got; (got = read(fd, chunk, sizeof(chunk))) > 0; ) {
+            for (ssize_t k = 0; k != got; ++k) {
+                if (chunk[k] != '\n') { line += chunk[k]; continue; }
+                __submit(line, client);
+                line.clear();
+            }
+        }
+        __submit(line, client);
+        client.reset();
+        { std::lock_guard<std::mutex> lock(mutex); --readers; }
+        ready.notify_one();
+    }
+
+    void __answer(Solver &worker, const Job &job) {
+        const Clock::time_point start = Clock::now();
+        std::uint32_t quality = 0;
+        std::vector<Action> rotation;
+        std::string answer;
+        if (!job.threshold) {
+            quality = worker.get_max_quality(job.state, job.min_progress);
+            rotation = worker.get_rotation(job.state, job.min_progress);
+        } else {
+            const bool reached = worker.find_rotation(job.state, job.min_progress, job.min_quality, rotation);
+            State state = job.state;
+            for (const Action action : rotation) {
+                quality += state.get_quality_potency(action);
+                state = state.use_action(action);
+            }
+            answer = "\"reached\": " + std::string(reached ? "true" : "false") + ", ";
+        }
+        const Clock::time_point done = Clock::now();
+
+        answer += "\"quality\": " + std::to_string(quality) + ", \"rotation\": [";
+        for (std::size_t i = 0; i != rotation.size(); ++i)
+            answer += (i == 0 ? "\"" : ", \"") + std::string(Actions::display_name[int(rotation[i])]) + '"';
+        answer += "], \"cached\": " + std::string(job.cached ? "true" : "false") + ", \"batched\": " + std::to_string(job.requests.size());
+        const std::uint64_t solve_us = std::chrono::duration_cast<std::chrono::microseconds>(done - start).count();
+        for (const Request *request : job.requests) {
+            const std::uint64_t queue_us = std::chrono::duration_cast<std::chrono::microseconds>(start - request->arrival).count();
+            request->client->send("{\"id\": " + request->id + ", " + answer + ", \"queue_us\": " + std::to_string(queue_us) + ", \"solve_us\": " + std::to_string(solve_us) + "}\n");
+            latency_us += queue_us + solve_us;
+            for (std::uint64_t max = max_latency_us; max < queue_us + solve_us && !max_latency_us.compare_exchange_weak(max, queue_us + solve_us); ) {}
+        }
+        answered += job.requests.size();
+        ++solved;
+        from_memo += job.cached;
+    }
+
+    // answers a batch of requests for one recipe
+    void __answer(const std::vector<Request> &batch) {
+        if (!Actions::init(batch.front().recipe)) {
+            for (const Request &request : batch)
+                request.client->send("{\"id\": " + request.id + ", \"error\": \"cp or durability of the recipe out of range\"}\n");
+            return;
+        }
+        std::vector<Job> jobs;
+        std::map<std::tuple<std::uint64_t, std::uint32_t, bool, std::uint32_t>, std::size_t> job_of;
+        for (const Request &request : batch) {
+            if (!Solver::fits(request.state)) { // would come back saturated
+                request.client->send("{\"id\": " + request.id + ", \"error\": \"progress or quality of the recipe out of range\"}\n");
+                continue;
+            }
+            const auto [it, inserted] = job_of.try_emplace({request.state.pack(), request.min_progress, request.threshold, request.min_quality}, jobs.size());
+            if (inserted) {
+                jobs.emplace_back();
+                jobs.back().state = request.state;
+                jobs.back().min_progress = request.min_progress;
+                jobs.back().min_quality = request.min_quality;
+                jobs.back().threshold = request.threshold;
+            }
+            jobs[it->second].requests.push_back(&request);
+        }
+        for (Job &job : jobs) job.cached = solver.is_memoized(job.state); // also drops a memo of another action table
+
+        if (jobs.size() == 1) {
+            __answer(solver, jobs.front());
+            return;
+        }
+        WorkStealingPool::TaskGroup group;
+        for (const Job &job : jobs)
+            pool.submit(group, [this, &job] { __answer(*workers[WorkStealingPool::worker_index()], job); });
+        pool.wait(group);
+    }
+
+public:
+    SolverServer(const unsigned threads, const std::size_t memory_budget):
+        solver(threads, BoundMode::Off, memory_budget),
+        pool(threads)
+    {
+        for (unsigned i = 0; i != threads; ++i) workers.push_back(solver.make_worker());
+    }
+
+    // reads requests from stdin and answers them on stdout
+    std::thread serve_stdin() {
+        { std::lock_guard<std::mutex> lock(mutex); ++readers; }
+        return std::thread(&SolverServer::__read, this, 0, std::make_shared<Client>(1));
+    }
+
+    // accepts clients on a Unix socket at path for as long as the server runs, false if it cannot listen
+    bool serve_socket(const std::string &path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) return false;
+        std::copy(path.begin(), path.end(), address.sun_path);
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(path.c_str());
+        if (fd < 0 || bind(fd, (sockaddr *)&address, sizeof(address)) != 0 || listen(fd, 64) != 0) {
+            if (fd >= 0) close(fd);
+            return false;
+        }
+        { std::lock_guard<std::mutex> lock(mutex); ++readers; } // the listener never finishes
+        std::thread([this, fd] {
+            for (int client; (client = accept(fd, nullptr, nullptr)) >= 0; ) {
+                { std::lock_guard<std::mutex> lock(mutex); ++readers; }
+                std::thread(&SolverServer::__read, this, client, std::make_shared<Client>(client)).detach();
+            }
+        }).detach();
+        return true;
+    }
+
+    // answers requests until every source is done
+    void run() {
+        while (true) {
+            std::vector<Request> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] { return !pending.empty() || readers == 0; });
+                if (pending.empty()) return;
+                // requests for the oldest pending recipe, the others stay queued in order
+                const Recipe recipe = pending.front().recipe;
+                std::deque<Request> rest;
+                for (Request &request : pending) {
+                    if (request.recipe == recipe) batch.push_back(std::move(request));
+                    else rest.push_back(std::move(request));
+                }
+                pending.swap(rest);
+            }
+            __answer(batch);
+        }
+    }
+
+    void print_summary(std::ostream &os) const {
+        os << "Requests: " << answered << " Solves: " << solved << " From memo: " << from_memo
+           << " Mean latency: " << (answered == 0 ? 0 : latency_us / answered) << "us Max latency: " << max_latency_us << "us\n";
+        const MemoStats memo = solver.get_memo_stats();
+        os << "Memo states: " << solver.get_memory_usage().states << " Hit rate: " << memo.hit_rate() << " Evictions: " << memo.evictions << '\n';
+    }
+};
+
+struct Options {
+    unsigned threads = 1;
+    const char *socket_path = nullptr; // stdin if null
+    std::size_t budget_mib = 0;
+};
+
+// fills options from argv, returns false on an unknown flag or a flag without its value
+bool parse_options(const int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        auto value = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+        auto number = [&](auto &out) {
+            const char *text = value();
+            if (text == nullptr) return false;
+            char *end;
+            const long long parsed = std::strtoll(text, &end, 10);
+            if (*text == '\0' || *end != '\0' || parsed < 0) return false;
+            out = parsed;
+            return true;
+        };
+        bool ok = true;
+        if (flag == "--threads") ok = number(options.threads) && options.threads != 0;
+        else if (flag == "--socket") ok = (options.socket_path = value()) != nullptr && *options.socket_path != '\0';
+        else if (flag == "--budget-mib") ok = number(options.budget_mib);
+        else ok = false;
+        if (!ok) {
+            std::cerr << "Bad argument " << flag << ", see the usage at the top of server.cpp\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::signal(SIGPIPE, SIG_IGN); // a client that disconnects early must not take the server down
+    Options options;
+    if (!parse_options(argc, argv, options)) return 1;
+
+    SolverServer server(options.threads, options.budget_mib << 20);
+    if (options.socket_path != nullptr) {
+        if (!server.serve_socket(options.socket_path)) {
+            std::cerr << "Could not listen on " << options.socket_path << '\n';
+            return 1;
+        }
+        server.run();
+        return 0;
+    }
+    std::thread reader = server.serve_stdin();
+    server.run();
+    reader.join();
+    server.print_summary(std::cerr);
+}
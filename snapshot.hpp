@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "actions.hpp"
+#include "state.hpp"
+#include "memo.hpp"
+#include "solve.hpp"
+
+// Snapshot files of a solver's memo. A file is mapped as is and handed to the solver as
+// SnapshotFronts, whose lookups hand out pointers straight into the mapping.
+//
+// layout: SnapshotHeader | keys[states] | starts[states + 1] | entries[entries] | tags[entries]
+// where the front of keys[i] is entries[starts[i], starts[i + 1]) and tags holds the action of every entry.
+template<typename Entry>
+class Snapshot {
+    static constexpr char MAGIC[8] = {'R', 'A', 'P', 'H', 'S', 'N', 'A', 'P'};
+    static constexpr std::uint32_t VERSION = 2; // bump whenever the search (actions, pruning, state layout) changes
+
+    struct SnapshotHeader {
+        char magic[8];
+        std::uint32_t version, entry_bytes;
+        std::uint64_t fingerprint;
+        std::uint64_t states, entries;
+    };
+
+    // read-only mapping of a whole file, unmapped with the last SnapshotFronts pointing into it
+    class Mapping {
+        Mapping() = default;
+
+    public:
+        const void *data = nullptr;
+        std::size_t size = 0;
+
+        Mapping(const Mapping &) = delete;
+        Mapping &operator = (const Mapping &) = delete;
+
+#ifdef _WIN32
+        ~Mapping() { if (data != nullptr) UnmapViewOfFile(data); }
+
+        static std::shared_ptr<const Mapping> map(const std::string &path) {
+            const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return nullptr;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size) || std::uint64_t(size.QuadPart) < sizeof(SnapshotHeader)) { CloseHandle(file); return nullptr; }
+            const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            CloseHandle(file);
+            if (mapping == nullptr) return nullptr;
+            const void *addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping); // the view keeps the mapping open
+            if (addr == nullptr) return nullptr;
+            std::shared_ptr<Mapping> result(new Mapping());
+            result->data = addr;
+            result->size = std::size_t(size.QuadPart);
+            return result;
+        }
+#else
+        ~Mapping() { if (data != nullptr) ::munmap(const_cast<void *>(data), size); }
+
+        static std::shared_ptr<const Mapping> map(const std::string &path) {
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return nullptr;
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(SnapshotHeader)) { ::close(fd); return nullptr; }
+            void *addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (addr == MAP_FAILED) return nullptr;
+            std::shared_ptr<Mapping> result(new Mapping());
+            result->data = addr;
+            result->size = st.st_size;
+            return result;
+        }
+#endif
+    };
+
+public:
+    // identifies the action table and recipe parameters a memo was built with
+    static std::uint64_t fingerprint() {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        auto mix = [&](const std::uint64_t x) { hash = (hash ^ x) * 0x100000001b3ull; };
+        mix(Actions::recipe.max_durability);
+        mix(Actions::recipe.base_progress_multiplier);
+        mix(Actions::recipe.base_quality_multiplier);
+        for (int i = 0; i < int(Action::COUNT); ++i) {
+            mix(Actions::cp_cost[i]); mix(Actions::dur_cost[i]);
+            mix(Actions::pim[i]); mix(Actions::qim[i]);
+            mix(int(Actions::combo_action[i]));
+        }
+        mix(State::CP_BITS); mix(State::DURABILITY_BITS); mix(State::EFFECT_BITS);
+        return hash;
+    }
+
+    // writes every front that for_each_front(add) passes to add(key, entries, tags, length)
+    template<typename F> static bool save(const std::string &path, F for_each_front) {
+        struct Front { std::uint64_t key; const Entry *entries; const std::uint8_t *tags; std::uint32_t length; };
+        std::vector<Front> fronts;
+        for_each_front([&](const std::uint64_t key, const Entry *first, const std::uint8_t *tags, const std::uint32_t length) {
+            fronts.push_back({key, first, tags, length});
+        });
+        std::sort(fronts.begin(), fronts.end(), [](const Front &lhs, const Front &rhs) { return lhs.key < rhs.key; });
+        fronts.erase(std::unique(fronts.begin(), fronts.end(), [](const Front &lhs, const Front &rhs) { return lhs.key == rhs.key; }), fronts.end());
+
+        SnapshotHeader header;
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.entry_bytes = sizeof(Entry);
+        header.fingerprint = fingerprint();
+        header.states = fronts.size();
+        std::vector<std::uint64_t> keys, starts{0};
+        for (const Front &front : fronts) {
+            keys.push_back(front.key);
+            starts.push_back(starts.back() + front.length);
+        }
+        header.entries = starts.back();
+
+        // write next to path and rename over it, a mapping of the old file stays valid
+        const std::string tmp_path = path + ".tmp";
+        std::FILE *file = std::fopen(tmp_path.c_str(), "wb");
+        if (file == nullptr) return false;
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1
+            && std::fwrite(keys.data(), sizeof(std::uint64_t), keys.size(), file) == keys.size()
+            && std::fwrite(starts.data(), sizeof(std::uint64_t), starts.size(), file) == starts.size();
+        for (const Front &front : fronts)
+            ok = ok && std::fwrite(front.entries, sizeof(Entry), front.length, file) == front.length;
+        for (const Front &front : fronts)
+            ok = ok && std::fwrite(front.tags, 1, front.length, file) == front.length;
+        ok = std::fclose(file) == 0 && ok;
+        if (ok) ok = std::rename(tmp_path.c_str(), path.c_str()) == 0;
+        if (!ok) std::remove(tmp_path.c_str());
+        return ok;
+    }
+
+    // maps path into fronts, returns false and leaves fronts alone if the file is missing, malformed or stale
+    static bool open(const std::string &path, SnapshotFronts<Entry> &fronts) {
+        const std::shared_ptr<const Mapping> mapping = Mapping::map(path);
+        if (mapping == nullptr) return false;
+
+        const SnapshotHeader &header = *static_cast<const SnapshotHeader *>(mapping->data);
+        const std::size_t expected_size = sizeof(SnapshotHeader)
+            + (2 * header.states + 1) * sizeof(std::uint64_t) + header.entries * (sizeof(Entry) + 1);
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION
+            || header.entry_bytes != sizeof(Entry) || header.fingerprint != fingerprint()
+            || mapping->size != expected_size)
+            return false;
+        fronts.owner = mapping;
+        fronts.states = header.states;
+        fronts.keys = reinterpret_cast<const std::uint64_t *>(static_cast<const char *>(mapping->data) + sizeof(SnapshotHeader));
+        fronts.starts = fronts.keys + fronts.states;
+        fronts.entries = reinterpret_cast<const Entry *>(fronts.starts + fronts.states + 1);
+        fronts.tags = reinterpret_cast<const std::uint8_t *>(fronts.entries + header.entries);
+        return true;
+    }
+};
+
+// Writes the memo of solver, including a loaded snapshot, to path. The file is tied to the current
+// action table, load_snapshot() rejects it once the recipe parameters no longer match.
+template<typename Entry> bool save_snapshot(ParetoSolver<Entry> &solver, const std::string &path) {
+    return Snapshot<Entry>::save(path, [&](auto add) { solver.for_each_front(add); });
+}
+
+// Maps a file written by save_snapshot() and answers the solver's lookups straight from it.
+// Returns false, leaving the solver cold, if the file is missing or was built for other parameters.
+template<typename Entry> bool load_snapshot(ParetoSolver<Entry> &solver, const std::string &path) {
+    SnapshotFronts<Entry> fronts;
+    if (!Snapshot<Entry>::open(path, fronts)) return false;
+    solver.set_snapshot(std::move(fronts));
+    return true;
+}
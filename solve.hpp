@@ -1,102 +1,670 @@
 #pragma once
 
 #include <vector>
-#include <unordered_map>
 #include <algorithm>
 #include <iostream>
 #include <cstring>
+#include <memory>
+#include <future>
+#include <chrono>
+#include <functional>
+#include <tuple>
+#include <atomic>
 
 #include "enums.hpp"
 #include "state.hpp"
 #include "actions.hpp"
 #include "pruning.hpp"
+#include "memo.hpp"
+#include "thread_pool.hpp"
+#include "pareto.hpp"
+#include "bound.hpp"
+#include "stats.hpp"
 #include "config.hpp"
 
-typedef std::vector<std::uint32_t> ParetoFront;
-
-class Solver {
-    static std::unordered_map<std::size_t, ParetoFront> sav;
-    std::uint32_t n = 0, m = 0, buf[1 << 16], ind[1 << 8];
-
-    void __merge_sort(const std::uint32_t sav_n, const std::uint32_t sav_m) {
-        std::uint32_t *src = buf + sav_n, *dst = buf + n;
-        for (std::uint32_t i; sav_m + 1 != m; m = sav_m + (i - sav_m) / 2) {
-            ind[m] = n;
-            for (i = sav_m; i < m; i += 2) { // iterate over segment indices
-                if (i + 2 <= m) { // merge 2 segments
-                    std::uint32_t l1 = ind[i] - sav_n, l2 = ind[i + 1] - sav_n, p = l1;
-                    const std::uint32_t r1 = l2, r2 = ind[i + 2] - sav_n;
-                    while (l1 != r1 && l2 != r2)
-                        if (src[l1] > src[l2]) dst[p++] = src[l1++];
-                        else dst[p++] = src[l2++];
-                    if (l1 != r1) std::memcpy(dst + p, src + l1, (r1 - l1) * sizeof(std::uint32_t));
-                    if (l2 != r2) std::memcpy(dst + p, src + l2, (r2 - l2) * sizeof(std::uint32_t));
-                } else { // copy 1 segment
-                    const std::uint32_t l = ind[i] - sav_n, r = ind[i + 1] - sav_n;
-                    std::memcpy(dst + l, src + l, (r - l) * sizeof(std::uint32_t));
+struct SearchStats {
+    std::size_t nodes_expanded = 0;  // states solved from scratch
+    std::size_t subtrees_pruned = 0; // child subtrees skipped by the upper bound
+    std::size_t dominance_reuses = 0; // states that took the front of memoized states around them
+};
+
+// answer of ParetoSolver::solve_anytime
+struct AnytimeAnswer {
+    std::uint32_t quality = 0; // of rotation
+    std::vector<Action> rotation; // empty if none reaching min_prog was found
+    bool exact = false; // the optimum, otherwise the best rotation of a coarse solve, a lower bound
+};
+
+struct MemoryUsage {
+    std::size_t states, entries, table_bytes, front_bytes;
+    std::size_t legacy_bytes; // estimated size of the same memo as std::unordered_map<std::size_t, std::vector<entry>>
+
+    double bytes_per_state() const { return states == 0 ? 0 : double(table_bytes + front_bytes) / states; }
+    double legacy_bytes_per_state() const { return states == 0 ? 0 : double(legacy_bytes) / states; }
+};
+
+enum struct Engine {
+    Recursive, // depth first __solve from the root, scratch of a fixed size
+    Layered,   // enumerates the reachable states and solves them children first, see __solve_layered, recursive under a budget
+};
+
+// Solves for Pareto fronts of Entry, see ParetoEntry. Every solver owns its memo, which the workers
+// of a parallel solve share. With a memory budget, fronts are evicted (see StripedMemo) and queries
+// solve evicted states again.
+template<typename Entry>
+class ParetoSolver {
+    typedef ParetoEntry<Entry> Traits;
+
+    struct Memo {
+        StripedMemo<Entry, true> sav; // every entry is tagged with the action that leads to it
+        Recipe recipe; // action table parameters sav was built with
+        SnapshotFronts<Entry> snapshot; // read-only fronts of an earlier solve, consulted before sav
+        SignatureIndex index; // cps in sav of every signature, only kept with dominance on
+        bool dominance = false;
+        bool canonical = false; // memoize canonicalize(state) instead of state, both have the same front
+        std::atomic<std::uint32_t> longest_front = 0; // length of the longest front memoized so far
+        int cp_quantum = 1; // cp is rounded down to a multiple of this before memoizing, see solve_anytime
+    };
+
+    // parallel solves fork child subtrees into separate tasks only near the root, below that a worker solves sequentially
+    static constexpr int PARALLEL_MAX_DEPTH = 4;
+    static constexpr int PARALLEL_MIN_CP = 100;
+    // and claim states with at least this much cp before solving them, see __solve, solving the
+    // smaller ones twice costs less than waiting for them
+    static constexpr int CLAIM_MIN_CP = 40;
+    // layered solves hand runs of independent states to the pool in chunks of this many
+    static constexpr std::size_t LAYER_CHUNK = 256;
+    // the coarse solves of solve_anytime round cp down to multiples of cp / ANYTIME_STEPS[i]
+    static constexpr int ANYTIME_STEPS[] = {5, 10, 20, 40, 80, 160};
+    // find_rotation solves states with at most 1/REACH_SOLVE_DIV of the cp budget left exactly, they
+    // are reached on many paths and their bounds are too loose to cut much
+    static constexpr int REACH_SOLVE_DIV = 2;
+
+    const std::shared_ptr<Memo> memo;
+    StripedMemo<Entry, true> &sav;
+    Recipe &sav_recipe;
+    SnapshotFronts<Entry> &snapshot;
+    const unsigned threads;
+    const BoundMode bound_mode;
+    Engine engine = Engine::Recursive;
+    SearchStats stats;
+    SolverStats profile; // only updated when built with SOLVER_STATS
+    std::uint32_t depth = 0; // of the state being solved, only tracked for profile
+    MemoTable<std::uint64_t> failures; // least (progress << 32 | quality) find_rotation could not reach from a state
+    Recipe failures_recipe;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    const std::atomic<bool> *cancel = nullptr; // polled like deadline
+    InFlight *claims = nullptr; // states being solved by the workers of a parallel solve, see __solve_parallel
+    bool aborted = false; // deadline passed or cancelled, nothing is memoized until the solve returns
+    std::atomic<bool> cancel_refinement = false;
+    std::unique_ptr<ParetoSolver> refiner; // exact solve started by solve_anytime
+    std::future<void> refinement;
+    std::uint32_t n = 0, m = 0;
+    std::vector<std::uint32_t> ind = std::vector<std::uint32_t>(1 << 10); // segment bounds in buf, grown by __solve
+    std::vector<std::uint8_t> segment_action = std::vector<std::uint8_t>(1 << 10); // action whose child front fills segment i of buf
+    std::vector<Entry> buf_storage = std::vector<Entry>(1 << 16);
+    std::vector<std::uint8_t> tags_storage = std::vector<std::uint8_t>(1 << 16);
+    Entry *buf = buf_storage.data(); // grown by __reserve, so never held across one
+    std::uint8_t *tags = tags_storage.data(); // actions of merged fronts, parallel to buf
+
+    void __solve(const State &raw, const Entry inc = 0) {
+        const State state = __memo_state(raw);
+        const std::uint64_t key = state.pack();
+        // this level adds at most a segment per action, one of its own and the closing bound
+        if (m + std::size(ALL_ACTIONS) + 2 > ind.size()) {
+            ind.resize(2 * ind.size());
+            segment_action.resize(ind.size());
+        }
+        if (m == 0 || ind[m - 1] != n) ind[m++] = n; // create new segment if starting position differs from prev segment
+
+        // if already solved -> write to buf and return
+        auto append = [&](const Entry *entries, const std::uint32_t length) {
+            __reserve(n + length);
+            for (std::uint32_t i = 0; i != length; ++i)
+                buf[n++] = Traits::add(entries[i], inc);
+        };
+        const bool solved = __lookup(key, append);
+        if constexpr (SolverStats::ENABLED) ++(solved ? profile.memo_hits : profile.memo_misses);
+        if (solved) return;
+        if (memo->dominance && __reuse_sandwiched(state, key, inc)) return;
+        // A state another worker is solving is waited for instead of solved twice. That worker only
+        // waits for states below state and this one only holds states above it, so waits never form a
+        // cycle. If the front did not get memoized after all (aborted or evicted), it is solved here.
+        while (claims != nullptr && state.cp >= CLAIM_MIN_CP && !claims->claim(key)) {
+            claims->wait(key);
+            if (__lookup(key, append)) return;
+        }
+        struct Release {
+            InFlight *claims;
+            std::uint64_t key;
+            ~Release() { if (claims != nullptr) claims->release(key); }
+        } release{state.cp >= CLAIM_MIN_CP ? claims : nullptr, key};
+        if (release.claims != nullptr && __lookup(key, append)) return; // memoized and released since the lookup above
+
+        const std::uint32_t sav_n = n; // same as ind[sav_m]
+        const std::uint32_t sav_m = m - 1;
+        ++stats.nodes_expanded;
+        if ((stats.nodes_expanded & 0xfff) == 0) aborted = aborted || __expired();
+        if (aborted) return;
+        if constexpr (SolverStats::ENABLED) ++profile.expanded_by_depth[std::min<std::uint32_t>(depth, SolverStats::MAX_DEPTH - 1)];
+
+        // solve all subtrees of the allowed actions, each action's transition is specialized
+        const ActionMask::Mask allowed = ActionMask::allowed(state);
+        if constexpr (SolverStats::ENABLED)
+            for (std::size_t i = 0; i != std::size(ALL_ACTIONS); ++i)
+                if (!(allowed >> i & 1)) ++(state.can_use_action(ALL_ACTIONS[i]) ? profile.rejected_should_use : profile.rejected_can_use)[int(ALL_ACTIONS[i])];
+        for_each_action(allowed, [&]<Action action>() {
+            if constexpr (SolverStats::ENABLED) ++profile.children_by_action[int(action)];
+            const std::uint32_t start = n;
+            const State new_state = state.use_action<action>();
+            const std::uint32_t prog = state.get_progress_potency(action);
+            const std::uint32_t qual = state.get_quality_potency(action);
+            if (new_state.durability != 0) {
+                if constexpr (SolverStats::ENABLED) ++depth;
+                __solve(new_state, Traits::pack(prog, qual));
+                if constexpr (SolverStats::ENABLED) --depth;
+            } else if (prog != 0) { // finishing action, gets a segment of its own so that every segment stays sorted
+                if (ind[m - 1] != n) ind[m++] = n;
+                __reserve(n + 1);
+                buf[n++] = Traits::pack(prog, qual);
+            }
+            if (n != start) segment_action[m - 1] = std::uint8_t(action); // the entries just written are the last segment
+        });
+
+        if (aborted) return; // some children were cut short
+        if (sav_m + 1 != m && ind[m - 1] == n) --m; // remove trailing segment if it is empty
+        ind[m] = n;
+        if (merge_observer != nullptr && sav_m + 1 != m) merge_observer(buf, ind.data() + sav_m, m - sav_m);
+        const auto start = SolverStats::ENABLED ? SolverStats::now() : std::chrono::steady_clock::time_point();
+        if (sav_m + 1 != m) { // merge segments into the scratch space behind them and move the front back
+            __reserve(2 * n - sav_n);
+            std::uint8_t *const front_tags = tags + n;
+            const std::uint32_t length = merge_pareto_fronts(buf, ind.data() + sav_m, m - sav_m, buf + n, [&](const std::uint32_t out, const std::uint32_t segment) {
+                front_tags[out] = segment_action[sav_m + segment];
+            });
+            if constexpr (SolverStats::ENABLED) {
+                ++profile.merge_calls;
+                profile.merge_ns += SolverStats::elapsed_ns(start);
+                profile.buf_high_water = std::max(profile.buf_high_water, n + length);
+                profile.ind_high_water = std::max(profile.ind_high_water, m + 1);
+            }
+            std::memcpy(buf + sav_n, buf + n, length * sizeof(Entry));
+            n = sav_n + length;
+            m = sav_m + 1;
+            __memoize(state, key, buf + sav_n, front_tags, n - sav_n);
+        } else {
+            if constexpr (SolverStats::ENABLED) profile.buf_high_water = std::max(profile.buf_high_water, n);
+            n = sav_n + build_pareto_front(buf + sav_n, n - sav_n);
+            if constexpr (SolverStats::ENABLED) {
+                ++profile.build_calls;
+                profile.build_ns += SolverStats::elapsed_ns(start);
+            }
+            std::memset(tags + sav_n, segment_action[sav_m], n - sav_n);
+            __memoize(state, key, buf + sav_n, tags + sav_n, n - sav_n);
+        }
+        if constexpr (SolverStats::ENABLED) profile.record_front(n - sav_n);
+
+        for (std::uint32_t i = sav_n; i != n; ++i) buf[i] = Traits::add(buf[i], inc);
+    }
+
+    // worker of a parallel or layered solve, stops with this solver
+    std::unique_ptr<ParetoSolver> __make_scratch_worker() const {
+        std::unique_ptr<ParetoSolver> worker = make_worker();
+        worker->deadline = deadline;
+        worker->cancel = cancel;
+        return worker;
+    }
+
+    // Fills the memo for state using a work-stealing pool. Subtrees near the root are forked into tasks
+    // and joined before their parent is merged, so the parent only ever reads finished children.
+    // Every worker merges with its own scratch buffer, and fronts do not depend on which thread
+    // computed them, so the memo ends up identical to a single-threaded solve.
+    void __solve_parallel(const State &state) {
+        WorkStealingPool pool(threads);
+        std::vector<std::unique_ptr<ParetoSolver>> scratch(threads);
+        InFlight claims; // tasks of different parents reach the same states, each is solved once
+        for (auto &worker : scratch) {
+            worker = __make_scratch_worker();
+            worker->claims = &claims;
+        }
+
+        std::function<void(const State, const int)> task = [&](const State state, const int depth) {
+            ParetoSolver &worker = *scratch[WorkStealingPool::worker_index()];
+            if (__contains(__key(state))) return;
+            if (depth < PARALLEL_MAX_DEPTH && state.cp >= PARALLEL_MIN_CP) {
+                WorkStealingPool::TaskGroup children;
+                const ActionMask::Mask allowed = ActionMask::allowed(state);
+                for (std::size_t i = 0; i != std::size(ALL_ACTIONS); ++i) {
+                    if (!(allowed >> i & 1)) continue;
+                    const State new_state = state.use_action(ALL_ACTIONS[i]);
+                    if (new_state.durability != 0) pool.submit(children, [&task, new_state, depth] { task(new_state, depth + 1); });
                 }
-                ind[sav_m + (i - sav_m) / 2] = ind[i]; // write back beginning index of merged segment
+                pool.wait(children);
             }
-            std::swap(src, dst);
+            worker.depth = depth;
+            worker.__solve(state); worker.n = 0; worker.m = 0;
+        };
+
+        WorkStealingPool::TaskGroup root;
+        pool.submit(root, [&] { task(state, 0); });
+        pool.wait(root);
+        for (const auto &worker : scratch) {
+            stats.nodes_expanded += worker->stats.nodes_expanded;
+            stats.dominance_reuses += worker->stats.dominance_reuses;
+            profile.merge(worker->profile);
+            aborted = aborted || worker->aborted;
         }
-        if (src != buf + sav_n) // odd #iterations
-            std::memcpy(buf + sav_n, buf + n, (n - sav_n) * sizeof(std::uint32_t));
     }
 
-    void __build_pareto_front(const std::uint32_t sav_n) {
-        std::uint32_t p = sav_n;
-        for (std::uint32_t i = sav_n + 1; i != n; ++i)
-            if ((buf[i] & 0xffff) > (buf[p] & 0xffff)) buf[++p] = buf[i];
-        n = p + 1;
+    // grows buf and tags to hold size entries, which moves them
+    void __reserve(const std::size_t size) {
+        if (size <= buf_storage.size()) return;
+        buf_storage.resize(std::max(size, 2 * buf_storage.size()));
+        tags_storage.resize(buf_storage.size());
+        buf = buf_storage.data();
+        tags = tags_storage.data();
     }
 
-    void __solve(const State &state, const std::uint32_t inc = 0) {
-        const std::size_t hash = std::hash<State>()(state);
-        if (m == 0 || ind[m - 1] != n) ind[m++] = n; // create new segment if starting position differs from prev segment
+    // A __solve whose children are all memoized writes their fronts and merges them behind, which
+    // takes at most twice the children's entries. Grows buf to that for any state up front.
+    void __reserve() {
+        __reserve(2 * (std::size(ALL_ACTIONS) + 1) * std::size_t(memo->longest_front.load(std::memory_order_relaxed) + 1));
+    }
 
-        // if already solved -> write to buf and return
-        if (sav.count(hash) != 0) {
-            for (const std::uint32_t x : sav.at(hash))
-                buf[n++] = x + inc;
-            return;
+    // Every transition lowers this order: all actions but Basic Synthesis cost cp, and Basic
+    // Synthesis runs down every effect timer or, with none running (so no Manipulation), durability.
+    static std::uint64_t __layer_order(const State &state) {
+        std::uint64_t timers = 0;
+        for (int i = 0; i != int(Effect::COUNT); ++i)
+            if (i != int(Effect::InnerQuiet)) timers += state.effects[i];
+        return std::uint64_t(state.cp) << 32 | timers << 16 | std::uint64_t(state.durability);
+    }
+
+    // Bottom up alternative to the recursive solve: enumerates the unsolved states reachable from
+    // init, then solves them layer by layer in increasing __layer_order. Children are memoized by
+    // the time their parent is expanded, so every __solve is one level deep and its scratch can be
+    // sized up front. States of equal order cannot reach each other and are solved by the pool.
+    // The fronts are those of the recursive engine. Only used without a memory budget, see solve().
+    void __solve_layered(const State &init) {
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> layers; // (order, key)
+        {
+            std::vector<std::uint64_t> keys;
+            MemoTable<bool> seen;
+            auto visit = [&](const State &state) {
+                const std::uint64_t key = __key(state);
+                if (seen.find(key) != nullptr || __contains(key)) return;
+                seen.emplace(key, true);
+                keys.push_back(key);
+            };
+            visit(init);
+            for (std::size_t i = 0; i != keys.size(); ++i) { // keys are canonical already
+                const State state = State::unpack(keys[i]);
+                for_each_action(ActionMask::allowed(state), [&]<Action action>() {
+                    const State new_state = state.use_action<action>();
+                    if (new_state.durability != 0) visit(new_state);
+                });
+            }
+            seen.clear();
+            layers.reserve(keys.size());
+            for (const std::uint64_t key : keys) layers.emplace_back(__layer_order(State::unpack(key)), key);
         }
+        std::sort(layers.begin(), layers.end());
 
-        const std::uint32_t sav_n = n; // same as ind[sav_m]
-        const std::uint32_t sav_m = m - 1;
+        auto expand = [](ParetoSolver &solver, const std::uint64_t key) {
+            solver.__reserve();
+            solver.__solve(State::unpack(key));
+            solver.n = 0; solver.m = 0;
+        };
+        std::unique_ptr<WorkStealingPool> pool;
+        std::vector<std::unique_ptr<ParetoSolver>> scratch;
+        if (threads > 1) {
+            pool = std::make_unique<WorkStealingPool>(threads);
+            scratch.resize(threads);
+            for (auto &worker : scratch) worker = __make_scratch_worker();
+        }
+        for (std::size_t first = 0, last; first != layers.size(); first = last) {
+            for (last = first + 1; last != layers.size() && layers[last].first == layers[first].first; ++last);
+            if (!pool || last - first <= LAYER_CHUNK) {
+                for (std::size_t i = first; i != last; ++i) expand(*this, layers[i].second);
+                continue;
+            }
+            WorkStealingPool::TaskGroup layer;
+            for (std::size_t begin = first; begin < last; begin += LAYER_CHUNK) {
+                const std::size_t end = std::min(last, begin + LAYER_CHUNK);
+                pool->submit(layer, [&, begin, end] {
+                    ParetoSolver &worker = *scratch[WorkStealingPool::worker_index()];
+                    for (std::size_t i = begin; i != end; ++i) expand(worker, layers[i].second);
+                });
+            }
+            pool->wait(layer);
+        }
+        for (const auto &worker : scratch) {
+            stats.nodes_expanded += worker->stats.nodes_expanded;
+            stats.dominance_reuses += worker->stats.dominance_reuses;
+            profile.merge(worker->profile);
+            aborted = aborted || worker->aborted;
+        }
+    }
 
-        // solve all subtrees
-        for (const Action action : ALL_ACTIONS) {
+    // Same answer as the plain get_best_action, but children are visited in order of their optimistic
+    // quality and only solved while that optimum can still beat (or tie earlier in ALL_ACTIONS with)
+    // the best child found so far. Children that cannot reach min_prog are never solved, their
+    // remaining quality counts as 0 just like in the plain search.
+    Action __get_best_action_bounded(const State &state, const std::uint32_t min_prog) {
+        struct Candidate {
+            int index;
+            Action action;
+            std::uint32_t prog, qual, optimistic;
+            State new_state;
+            bool solved; // qual is already exact, the child cannot reach min_prog
+        };
+        std::vector<Candidate> candidates;
+        for (int i = 0; i != int(std::size(ALL_ACTIONS)); ++i) {
+            const Action action = ALL_ACTIONS[i];
             if (!state.can_use_action(action) || !should_use_action(state, action)) continue;
-            State new_state = state.use_action(action);
+            const State new_state = state.use_action(action);
             const std::uint32_t prog = state.get_progress_potency(action);
             const std::uint32_t qual = state.get_quality_potency(action);
-            if (new_state.durability != 0) __solve(new_state, prog << 16 | qual);
-            else if (prog != 0) buf[n++] = prog << 16 | qual;
+            const bool reachable = prog >= min_prog || (new_state.durability != 0 && prog + Bound::progress_upper_bound(new_state) >= min_prog);
+            if (!reachable && new_state.durability == 0) continue; // plain search drops these too
+            if (!reachable) candidates.push_back(Candidate{i, action, prog, qual, qual, new_state, true});
+            else candidates.push_back(Candidate{i, action, prog, qual, qual + Bound::quality_upper_bound(new_state), new_state, false});
         }
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &lhs, const Candidate &rhs) {
+            return lhs.optimistic > rhs.optimistic;
+        });
 
-        if (sav_m + 1 != m && ind[m - 1] == n) --m; // remove trailing segment if it is empty
-        if (sav_m + 1 != m) {
-            __merge_sort(sav_n, sav_m);
-            __build_pareto_front(sav_n);
+        std::uint32_t best_qual = 0;
+        int best_index = int(std::size(ALL_ACTIONS));
+        for (const Candidate &candidate : candidates) {
+            if (candidate.optimistic < best_qual || (candidate.optimistic == best_qual && candidate.index > best_index)) {
+                ++stats.subtrees_pruned;
+                continue;
+            }
+            std::uint32_t qual = candidate.qual;
+            if (candidate.solved) ++stats.subtrees_pruned;
+            else if (candidate.new_state.durability != 0) {
+                solve(candidate.new_state);
+                qual += get_max_quality(candidate.new_state, candidate.prog > min_prog ? 0 : min_prog - candidate.prog);
+            }
+            if (qual > best_qual || (qual == best_qual && qual != 0 && candidate.index < best_index)) {
+                best_qual = qual;
+                best_index = candidate.index;
+            }
+        }
+        return best_index == int(std::size(ALL_ACTIONS)) ? Action::Null : ALL_ACTIONS[best_index];
+    }
+
+    // Depth first search for a rotation from state that adds need_prog progress and need_qual
+    // quality, appended to rotation. Memoized and low cp states answer from their front, the rest try
+    // their children by optimistic quality and give up on needs above the bounds or a recorded failure.
+    // Searches the same actions as __solve, so it succeeds iff the front of state has such an entry.
+    bool __reach(const State &state, const std::uint32_t need_prog, const std::uint32_t need_qual, std::vector<Action> &rotation) {
+        const std::uint64_t key = __key(state);
+        if (state.cp * REACH_SOLVE_DIV <= Actions::recipe.max_cp) { __solve(state); n = 0; m = 0; }
+        bool memoized = false, reached = false;
+        __lookup(key, [&](const Entry *entries, const std::uint32_t length) {
+            auto iter = std::lower_bound(std::make_reverse_iterator(entries + length), std::make_reverse_iterator(entries), Traits::pack(need_prog, 0));
+            reached = iter != std::make_reverse_iterator(entries) && Traits::quality(*iter) >= need_qual;
+            memoized = true;
+        });
+        if (memoized) {
+            if (reached) for (const Action action : get_rotation(state, need_prog)) rotation.push_back(action);
+            return reached;
+        }
+        if (need_prog > Bound::progress_upper_bound(state) || need_qual > Bound::quality_upper_bound(state)) {
+            ++stats.subtrees_pruned;
+            return false;
+        }
+        const std::uint64_t *failed = failures.find(key);
+        if (failed != nullptr && need_prog >= (*failed >> 32) && need_qual >= std::uint32_t(*failed)) return false;
+        ++stats.nodes_expanded;
+
+        struct Candidate {
+            Action action;
+            std::uint32_t prog, qual, optimistic;
+            State new_state;
+        };
+        std::vector<Candidate> candidates;
+        const ActionMask::Mask allowed = ActionMask::allowed(state);
+        for (std::size_t i = 0; i != std::size(ALL_ACTIONS); ++i) {
+            if (!(allowed >> i & 1)) continue;
+            const Action action = ALL_ACTIONS[i];
+            const State new_state = state.use_action(action);
+            const std::uint32_t prog = state.get_progress_potency(action);
+            const std::uint32_t qual = state.get_quality_potency(action);
+            if (new_state.durability != 0) candidates.push_back(Candidate{action, prog, qual, qual + Bound::quality_upper_bound(new_state), new_state});
+            else if (prog != 0 && prog >= need_prog && qual >= need_qual) { // finishing action
+                rotation.push_back(action);
+                return true;
+            }
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &lhs, const Candidate &rhs) {
+            return lhs.optimistic > rhs.optimistic;
+        });
+        for (const Candidate &candidate : candidates) {
+            if (candidate.optimistic < need_qual) break; // sorted, none of the rest can make it either
+            rotation.push_back(candidate.action);
+            if (__reach(candidate.new_state, need_prog > candidate.prog ? need_prog - candidate.prog : 0,
+                        need_qual > candidate.qual ? need_qual - candidate.qual : 0, rotation)) return true;
+            rotation.pop_back();
+        }
+
+        const std::uint64_t need = std::uint64_t(need_prog) << 32 | need_qual;
+        std::uint64_t &least = failures.emplace(key, need); // the recursion may have moved failed
+        if (need_prog <= (least >> 32) && need_qual <= std::uint32_t(least)) least = need;
+        return false;
+    }
+
+    // eviction passes a front survives unused, high cp states span the largest subtrees
+    static int __cost(const State &state) {
+        return std::min(3, 1 + 3 * state.cp / (Actions::recipe.max_cp + 1));
+    }
+
+    bool __expired() const {
+        if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) return true;
+        return deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= deadline;
+    }
+
+    // state whose front is memoized for raw, less cp only loses quality
+    State __memo_state(const State &raw) const {
+        State state = raw;
+        if (memo->cp_quantum != 1) state.cp -= state.cp % memo->cp_quantum;
+        return memo->canonical ? canonicalize(state) : state;
+    }
+
+    // memo key of state
+    std::uint64_t __key(const State &state) const {
+        return __memo_state(state).pack();
+    }
+
+    void __memoize(const State &state, const std::uint64_t key, const Entry *entries, const std::uint8_t *front_tags, const std::uint32_t length) {
+        sav.insert(key, entries, length, front_tags, __cost(state));
+        std::uint32_t longest = memo->longest_front.load(std::memory_order_relaxed);
+        while (length > longest && !memo->longest_front.compare_exchange_weak(longest, length, std::memory_order_relaxed));
+        if (memo->dominance) memo->index.insert(key >> State::CP_BITS, std::uint16_t(state.cp));
+    }
+
+    // A front can only grow with cp: no action needs less cp, none gives cp back and pruning ignores
+    // cp. So a state between two memoized states of its signature whose fronts are equal has that
+    // front as well, it is written to buf like a memo hit and memoized without solving.
+    bool __reuse_sandwiched(const State &state, const std::uint64_t key, const Entry inc) {
+        const std::uint64_t signature = key >> State::CP_BITS;
+        std::uint16_t below, above;
+        if (!memo->index.neighbors(signature, std::uint16_t(state.cp), below, above)) return false;
+        std::uint32_t length = 0;
+        if (!sav.lookup_tagged(signature << State::CP_BITS | below, [&](const Entry *entries, const std::uint8_t *front_tags, const std::uint32_t below_length) {
+            length = below_length;
+            __reserve(n + length);
+            std::memcpy(buf + n, entries, length * sizeof(Entry));
+            std::memcpy(tags + n, front_tags, length); // actions valid below are valid with more cp
+        })) {
+            memo->index.erase(signature, below); // evicted
+            return false;
         }
-        sav.emplace(hash, ParetoFront(buf + sav_n, buf + n));
+        bool equal = false;
+        if (!sav.lookup(signature << State::CP_BITS | above, [&](const Entry *entries, const std::uint32_t above_length) {
+            equal = above_length == length && std::memcmp(entries, buf + n, length * sizeof(Entry)) == 0;
+        })) {
+            memo->index.erase(signature, above);
+            return false;
+        }
+        if (!equal) return false;
+        __memoize(state, key, buf + n, tags + n, length);
+        for (std::uint32_t i = 0; i != length; ++i) buf[n + i] = Traits::add(buf[n + i], inc);
+        n += length;
+        ++stats.dominance_reuses;
+        return true;
+    }
+
+    // drops the memo if the action table changed since it was built
+    void __sync_recipe() {
+        if (sav_recipe.same_action_table(Actions::recipe)) return;
+        sav.clear();
+        memo->index.clear();
+        snapshot.clear();
+        sav_recipe = Actions::recipe;
+    }
+
+    template<typename F> bool __lookup(const std::uint64_t key, F f) const {
+        return snapshot.lookup(key, f) || sav.lookup(key, f);
+    }
+
+    template<typename F> bool __lookup_tagged(const std::uint64_t key, F f) const {
+        return snapshot.lookup_tagged(key, f) || sav.lookup_tagged(key, f);
+    }
 
-        for (std::uint32_t i = sav_n; i != n; ++i) buf[i] += inc;
+    bool __contains(const std::uint64_t key) const {
+        return __lookup(key, [](const Entry *, const std::uint32_t) {});
     }
 
 public:
-    static std::uint32_t get_max_quality(const State state, const std::uint32_t min_prog) {
-        if (state.durability != 0) {
-            const ParetoFront &entries = sav[std::hash<State>()(state)];
-            auto iter = std::lower_bound(entries.rbegin(), entries.rend(), min_prog << 16);
-            if (iter != entries.rend()) return *iter & 0xffff;
+    // called with the segments of every merge of two or more child fronts, see merge_bench.cpp
+    static void (*merge_observer)(const Entry *buf, const std::uint32_t *bounds, std::uint32_t k);
+
+private:
+    ParetoSolver(const std::shared_ptr<Memo> &memo, const unsigned threads, const BoundMode bound_mode):
+        memo(memo),
+        sav(memo->sav),
+        sav_recipe(memo->recipe),
+        snapshot(memo->snapshot),
+        threads(threads),
+        bound_mode(bound_mode)
+    {}
+
+public:
+    // memory_budget caps the bytes of the memo, 0 for unlimited
+    explicit ParetoSolver(const unsigned threads = 1, const BoundMode bound_mode = BoundMode::Off, const std::size_t memory_budget = 0):
+        ParetoSolver(std::make_shared<Memo>(), threads, bound_mode)
+    {
+        sav.set_budget(memory_budget);
+    }
+
+    ~ParetoSolver() {
+        cancel_refinement = true; // nobody can ask for the result any more
+        if (refinement.valid()) refinement.wait();
+    }
+
+    ParetoSolver(const ParetoSolver &) = delete;
+    ParetoSolver &operator = (const ParetoSolver &) = delete;
+
+    // Whether Entry stores every front reachable from state exactly under the current action table,
+    // otherwise sums would saturate. Checked on the bounds, so it may turn down a state that would fit.
+    static bool fits(const State &state) {
+        return Traits::fits(Bound::progress_upper_bound(state), Bound::quality_upper_bound(state));
+    }
+
+    // single threaded solver sharing this one's memo, for answering queries concurrently
+    std::unique_ptr<ParetoSolver> make_worker() const {
+        return std::unique_ptr<ParetoSolver>(new ParetoSolver(memo, 1, BoundMode::Off));
+    }
+
+    const SearchStats &get_search_stats() const { return stats; }
+
+    // hot path counters, all zero unless built with SOLVER_STATS
+    const SolverStats &get_solver_stats() const { return profile; }
+
+    // Reuses the fronts of memoized states for states sandwiched between them in cp, which cuts
+    // the states solved at the cost of an index of the memoized cps. Shared with make_worker().
+    // Only the recursive engine gains from it, the layered one solves states in increasing cp and
+    // never has a memoized state above the one it solves.
+    void set_dominance(const bool enabled) {
+        if (!enabled) memo->index.clear();
+        memo->dominance = enabled;
+    }
+
+    // Memoizes every state under its canonicalize() representative, so that states with the same
+    // front share one entry. Shared with make_worker(), memos may mix keys of both modes.
+    void set_canonical(const bool enabled) { memo->canonical = enabled; }
+
+    // How solve() fills the memo, both engines memoize the same fronts. Not shared with make_worker().
+    // With a memory budget solve() is always recursive, see there. The layered engine never reuses
+    // fronts, see set_dominance().
+    void set_engine(const Engine selected) { engine = selected; }
+
+    // Solves init in two fresh memos, one of them canonical, and returns the number of states of
+    // the plain solve whose front differs from the one memoized for their representative.
+    static std::size_t verify_canonicalization(const State init) {
+        ParetoSolver plain, canonical;
+        canonical.set_canonical(true);
+        plain.solve(init);
+        canonical.solve(init);
+        std::size_t mismatches = 0;
+        plain.sav.for_each([&](const std::uint64_t key, const Entry *entries, const std::uint32_t length) {
+            const State state = State::unpack(key);
+            bool equal = false;
+            auto compare = [&](const Entry *other, const std::uint32_t other_length) {
+                equal = other_length == length && std::memcmp(other, entries, length * sizeof(Entry)) == 0;
+            };
+            if (!canonical.__lookup(canonical.__key(state), compare)) { // representative not reached from init
+                canonical.solve(state);
+                canonical.__lookup(canonical.__key(state), compare);
+            }
+            if (!equal) ++mismatches;
+        });
+        return mismatches;
+    }
+
+    // true if state can be answered from the memo without solving
+    bool is_memoized(const State state) {
+        __sync_recipe();
+        return state.durability == 0 || __contains(__key(state));
+    }
+
+    // fills the memo for state and every state reachable from it
+    void solve(const State state) {
+        __sync_recipe();
+        if (state.durability == 0 || __contains(__key(state))) return;
+        if (refinement.valid()) { // solve_anytime is filling this memo, solving alongside it would redo its work
+            wait_for_refinement();
+            if (__contains(__key(state))) return;
+        }
+        // the layered engine holds every reachable key whatever the budget, and a child evicted before
+        // its parent is expanded would be solved recursively on a scratch sized for one level
+        if (engine == Engine::Layered && sav.budget() == 0) __solve_layered(state);
+        else if (threads > 1) __solve_parallel(state);
+        else { __solve(state); n = 0; m = 0; } // solve state and clear buffer
+    }
+
+    // max quality reachable from state with at least min_prog progress, solves state if it is not memoized
+    std::uint32_t get_max_quality(const State state, const std::uint32_t min_prog) {
+        std::uint32_t qual = 0;
+        if (state.durability == 0) return qual;
+        auto query = [&](const Entry *entries, const std::uint32_t length) {
+            auto iter = std::lower_bound(std::make_reverse_iterator(entries + length), std::make_reverse_iterator(entries), Traits::pack(min_prog, 0));
+            if (iter != std::make_reverse_iterator(entries)) qual = Traits::quality(*iter);
+        };
+        if (!__lookup(__key(state), query)) {
+            solve(state);
+            __lookup(__key(state), query);
         }
-        return 0;
+        return qual;
     }
 
     Action get_best_action(const State state, const std::uint32_t min_prog) {
         if (state.durability == 0) return Action::Null;
-        __solve(state); n = 0; m = 0; // solve state and clear buffer
+        if (bound_mode == BoundMode::Root) return __get_best_action_bounded(state, min_prog);
+        solve(state);
         std::uint32_t best_qual = 0;
         Action best_action = Action::Null;
         for (const Action action : ALL_ACTIONS) {
@@ -104,33 +672,229 @@ public:
             std::uint32_t prog = state.get_progress_potency(action);
             std::uint32_t qual = state.get_quality_potency(action);
             State new_state = state.use_action(action);
-            if (new_state.durability != 0) qual += get_max_quality(new_state, min_prog - prog);
+            if (new_state.durability != 0) qual += get_max_quality(new_state, prog > min_prog ? 0 : min_prog - prog);
             else if (prog < min_prog) continue;
             if (qual > best_qual) { best_qual = qual; best_action = action; }
         }
         return best_action;
     }
 
-    void print_debug_info(const State init) {
-        std::cout << "Unique states: " << sav.size() << ' ';
-        std::cout << "Initial state size: " << sav.at(std::hash<State>()(init)).size() << '\n';
-        std::cout << get_max_quality(init, Config::MAX_PROGRESS);
-
-        State cur_state = init;
-        std::uint32_t min_prog = Config::MAX_PROGRESS;
-        while (cur_state.durability > 0) {
-            Action best_action = get_best_action(cur_state, min_prog);
-            const std::uint32_t prog = cur_state.get_progress_potency(best_action);
-            min_prog = prog > min_prog ? 0 : min_prog - prog;
-            cur_state = cur_state.use_action(best_action);
-            std::cout << " >> " << Actions::display_name[int(best_action)];
-            if (best_action == Action::Null) {
-                std::cout << "\nUnexpected error occured";
-                break;
+    // Optimal rotation from state for min_prog, read off the action tags of the memo in one walk
+    // without expanding any state. Empty if min_prog cannot be reached.
+    std::vector<Action> get_rotation(const State state, const std::uint32_t min_prog) {
+        solve(state);
+        std::vector<Action> rotation;
+        State cur_state = state;
+        std::uint32_t target = min_prog;
+        while (cur_state.durability != 0) {
+            Action action = Action::Null;
+            auto query = [&](const Entry *entries, const std::uint8_t *front_tags, const std::uint32_t length) {
+                // entry with the least progress that still reaches target, which has the most quality
+                auto iter = std::lower_bound(std::make_reverse_iterator(entries + length), std::make_reverse_iterator(entries), Traits::pack(target, 0));
+                if (iter != std::make_reverse_iterator(entries)) action = Action(front_tags[&*iter - entries]);
+            };
+            if (!__lookup_tagged(__key(cur_state), query)) { // evicted since
+                solve(cur_state);
+                __lookup_tagged(__key(cur_state), query);
+            }
+            if (action == Action::Null) break;
+            rotation.push_back(action);
+            const std::uint32_t prog = cur_state.get_progress_potency(action);
+            target = prog > target ? 0 : target - prog;
+            cur_state = cur_state.use_action(action);
+        }
+        return rotation;
+    }
+
+    // Rotation from state that reaches min_prog progress and min_qual quality, stopping at the first
+    // one found instead of solving the whole front, only the low cp states it meets are memoized.
+    // False and an empty rotation if no rotation reaches both.
+    bool find_rotation(const State state, const std::uint32_t min_prog, const std::uint32_t min_qual, std::vector<Action> &rotation) {
+        __sync_recipe();
+        if (!failures_recipe.same_action_table(Actions::recipe)) {
+            failures.clear();
+            failures_recipe = Actions::recipe;
+        }
+        rotation.clear();
+        return state.durability != 0 && __reach(state, min_prog, min_qual, rotation);
+    }
+
+    // Best rotation from state for min_prog that can be found by deadline. Starts an exact solve of
+    // state into the memo in the background unless one is running already, and meanwhile solves
+    // coarse problems in memos of their own: every state is solved with its cp rounded down to a
+    // multiple of state.cp / ANYTIME_STEPS[i], for ever finer steps. Nothing is pruned, the coarse
+    // state space just has fewer states, and its rotations are valid since the real cp is never
+    // less, so their quality is a lower bound on the optimum. The answer is exact if the full solve
+    // is done by the deadline, otherwise later calls get it once it is, and solve() waits for it
+    // instead of solving again. Actions::recipe must not change until wait_for_refinement()
+    // returns, destroying the solver cancels the refinement.
+    AnytimeAnswer solve_anytime(const State state, const std::uint32_t min_prog, const std::chrono::steady_clock::time_point deadline) {
+        AnytimeAnswer answer;
+        if (state.durability == 0) return answer;
+        __sync_recipe();
+        auto refined = [&] {
+            return __contains(__key(state)) && (!refinement.valid() || refinement.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        };
+        if (!__contains(__key(state)) && !is_refining()) {
+            refiner.reset(new ParetoSolver(memo, threads, BoundMode::Off));
+            refiner->engine = engine;
+            refiner->cancel = &cancel_refinement;
+            refinement = std::async(std::launch::async, [this, state] { refiner->solve(state); });
+        }
+        for (const int steps : ANYTIME_STEPS) {
+            const int quantum = state.cp / steps;
+            if (quantum < 2 || refined() || std::chrono::steady_clock::now() >= deadline) break;
+            ParetoSolver coarse(1, BoundMode::Off);
+            coarse.memo->canonical = memo->canonical;
+            coarse.memo->cp_quantum = quantum;
+            coarse.deadline = deadline;
+            coarse.solve(state);
+            if (coarse.aborted) break;
+            std::vector<Action> rotation = coarse.get_rotation(state, min_prog);
+            if (coarse.aborted) break; // the walk solved real states the coarse solve did not reach and was cut short
+            std::uint32_t progress = 0, quality = 0;
+            State cur_state = state;
+            for (const Action action : rotation) {
+                progress += cur_state.get_progress_potency(action);
+                quality += cur_state.get_quality_potency(action);
+                cur_state = cur_state.use_action(action);
+            }
+            const bool finished = !rotation.empty() && cur_state.durability == 0 && progress >= min_prog;
+            if (finished && (answer.rotation.empty() || quality > answer.quality)) {
+                answer.quality = quality;
+                answer.rotation = std::move(rotation);
             }
         }
+        if (refinement.valid() && deadline != std::chrono::steady_clock::time_point::max()) refinement.wait_until(deadline);
+        else wait_for_refinement();
+        if (refined()) {
+            answer.rotation = get_rotation(state, min_prog);
+            answer.quality = answer.rotation.empty() ? 0 : get_max_quality(state, min_prog);
+            answer.exact = true;
+        }
+        return answer;
+    }
+
+    // true while an exact solve started by solve_anytime is running
+    bool is_refining() const {
+        return refinement.valid() && refinement.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    }
+
+    void wait_for_refinement() {
+        if (refinement.valid()) refinement.get();
+        refiner.reset();
+    }
+
+    // Pareto front of (progress, quality) pairs reachable from state, in decreasing progress
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> get_pareto_front(const State state) {
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> front;
+        solve(state);
+        __lookup(__key(state), [&](const Entry *entries, const std::uint32_t length) {
+            for (std::uint32_t i = 0; i != length; ++i) front.emplace_back(Traits::progress(entries[i]), Traits::quality(entries[i]));
+        });
+        return front;
+    }
+
+    // max quality for every progress target, from a single solve of state
+    std::vector<std::uint32_t> get_max_quality(const State state, const std::vector<std::uint32_t> &min_progs) {
+        solve(state);
+        std::vector<std::uint32_t> quals;
+        for (const std::uint32_t min_prog : min_progs) quals.push_back(get_max_quality(state, min_prog));
+        return quals;
+    }
+
+    // Max quality reachable for every recipe, starting from full cp and durability.
+    // Recipes that share an action table are solved back to back, so they reuse the same memo.
+    // Recipes whose gains do not fit Entry are solved with 64-bit entries instead, recipes whose cp or
+    // durability do not fit a State (see Recipe::in_range) get 0.
+    std::vector<std::uint32_t> get_max_quality(const std::vector<Recipe> &recipes) {
+        std::vector<std::size_t> order(recipes.size());
+        for (std::size_t i = 0; i != order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](const std::size_t lhs, const std::size_t rhs) {
+            const Recipe &a = recipes[lhs], &b = recipes[rhs];
+            return std::tie(a.max_durability, a.base_progress_multiplier, a.base_quality_multiplier)
+                 < std::tie(b.max_durability, b.base_progress_multiplier, b.base_quality_multiplier);
+        });
+
+        const Recipe saved_recipe = Actions::recipe;
+        std::vector<std::uint32_t> quals(recipes.size());
+        for (const std::size_t i : order) {
+            if (!recipes[i].in_range()) continue;
+            if (!Actions::recipe.same_action_table(recipes[i])) Actions::init(recipes[i]);
+            const State init(recipes[i].max_cp, recipes[i].max_durability);
+            if constexpr (sizeof(Entry) < sizeof(std::uint64_t)) {
+                if (!fits(init)) { // gains overflow Entry, solved with wide entries in a memo of their own
+                    quals[i] = ParetoSolver<std::uint64_t>(threads).get_max_quality(init, recipes[i].max_progress);
+                    continue;
+                }
+            }
+            solve(init);
+            quals[i] = get_max_quality(init, recipes[i].max_progress);
+        }
+        if (!Actions::recipe.same_action_table(saved_recipe)) Actions::init(saved_recipe);
+        else Actions::recipe = saved_recipe;
+        return quals;
+    }
+
+    // Answers lookups from fronts before the memo, see load_snapshot() in snapshot.hpp. They are
+    // dropped with the memo once the action table changes, so fronts must be built for the current one.
+    void set_snapshot(SnapshotFronts<Entry> fronts) {
+        __sync_recipe();
+        snapshot = std::move(fronts);
+        const std::uint32_t length = snapshot.longest(); // sizes the scratch of the layered engine, see __reserve
+        std::uint32_t longest = memo->longest_front.load(std::memory_order_relaxed);
+        while (length > longest && !memo->longest_front.compare_exchange_weak(longest, length, std::memory_order_relaxed));
+    }
+
+    // calls add(key, entries, tags, length) for every memoized front, the snapshot's included
+    template<typename F> void for_each_front(F add) {
+        __sync_recipe();
+        snapshot.for_each_tagged(add);
+        sav.for_each_tagged(add);
+    }
+
+    // drops every memoized front and the snapshot, so the next solve starts cold
+    void clear_memo() {
+        sav.clear();
+        failures.clear();
+        memo->index.clear();
+        snapshot.clear();
+    }
+
+    MemoryUsage get_memory_usage() const {
+        MemoryUsage usage{sav.size(), 0, sav.table_bytes() + memo->index.bytes_used(), sav.front_bytes(), 0};
+        // libstdc++: 8 bytes per bucket, 48 byte node chunk, vector data rounded up to a malloc chunk
+        usage.legacy_bytes = sav.size() * (8 + 48);
+        sav.for_each([&](std::uint64_t, const Entry *, const std::uint32_t length) {
+            usage.entries += length;
+            if (length != 0) usage.legacy_bytes += std::max<std::size_t>(32, (length * sizeof(Entry) + 8 + 15) / 16 * 16);
+        });
+        return usage;
+    }
+
+    MemoStats get_memo_stats() const { return sav.stats(); }
+
+    void print_debug_info(const State init) {
+        const SearchStats search = stats;
+        solve(init); // the bounded search may have left parts of init unsolved
+        const MemoryUsage usage = get_memory_usage();
+        std::cout << "Unique states: " << sav.size() + snapshot.size() << ' ';
+        std::uint32_t init_size = 0;
+        __lookup(__key(init), [&](const Entry *, const std::uint32_t length) { init_size = length; });
+        std::cout << "Initial state size: " << init_size << '\n';
+        std::cout << "Nodes expanded: " << search.nodes_expanded << " Subtrees pruned: " << search.subtrees_pruned << " Dominance reuses: " << search.dominance_reuses << '\n';
+        std::cout << "Memo bytes per state: " << usage.bytes_per_state() << " (unordered_map + vector: " << usage.legacy_bytes_per_state() << ")\n";
+        const MemoStats memo_stats = sav.stats();
+        std::cout << "Memo hit rate: " << memo_stats.hit_rate() << " Evictions: " << memo_stats.evictions << " Compactions: " << memo_stats.compactions << '\n';
+        std::cout << get_max_quality(init, Actions::recipe.max_progress);
+
+        const std::vector<Action> rotation = get_rotation(init, Actions::recipe.max_progress);
+        for (const Action action : rotation) std::cout << " >> " << Actions::display_name[int(action)];
+        if (rotation.empty()) std::cout << "\nNo rotation reaches the progress target";
         std::cout << '\n';
     }
 };
 
-std::unordered_map<std::size_t, ParetoFront> Solver::sav = std::unordered_map<std::size_t, ParetoFront>();
\ No newline at end of file
+template<typename Entry> void (*ParetoSolver<Entry>::merge_observer)(const Entry *, const std::uint32_t *, std::uint32_t) = nullptr;
+
+typedef ParetoSolver<DefaultEntry> Solver;
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <iostream>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
 
 #include "actions.hpp"
 #include "config.hpp"
@@ -19,72 +23,84 @@ struct State {
         last_action(Action::None)
     {}
 
+    // bit layout, from least significant: cp (16), durability (8), effects (4 each), condition (4), last_action (5)
+    static constexpr int CP_BITS = 16, DURABILITY_BITS = 8, EFFECT_BITS = 4, CONDITION_BITS = 4, ACTION_BITS = 5;
+
+    // largest value of each effect: Inner Quiet stacks, otherwise the longest timer use_action()
+    // sets, which is 2 steps longer under Primed
+    static constexpr std::array<int, int(Effect::COUNT)> MAX_EFFECTS = {Actions::MAX_INNER_QUIET, 8 + 2, 4 + 2, 4 + 2, 3 + 2, 5 + 2, 8 + 2};
+
+    std::uint64_t pack() const {
+        std::uint64_t key = int(last_action);
+        key = key << CONDITION_BITS | int(condition);
+        for (int i = int(Effect::COUNT) - 1; i >= 0; --i)
+            key = key << EFFECT_BITS | effects[i];
+        key = key << DURABILITY_BITS | durability;
+        return key << CP_BITS | cp;
+    }
+
+    static State unpack(std::uint64_t key) {
+        State state(0, 0);
+        state.cp = key & ((1 << CP_BITS) - 1); key >>= CP_BITS;
+        state.durability = key & ((1 << DURABILITY_BITS) - 1); key >>= DURABILITY_BITS;
+        for (int i = 0; i < int(Effect::COUNT); ++i) {
+            state.effects[i] = key & ((1 << EFFECT_BITS) - 1); key >>= EFFECT_BITS;
+        }
+        state.condition = Condition(key & ((1 << CONDITION_BITS) - 1)); key >>= CONDITION_BITS;
+        state.last_action = Action(key);
+        return state;
+    }
+
     int get_cp_cost(const Action action) const {
         return Actions::cp_cost[int(action)];
     }
 
     int get_durability_cost(const Action action) const {
-        if (effects[int(Effect::WasteNot)] != 0)
-            return (Actions::dur_cost[int(action)] + 1) / 2;
-        return Actions::dur_cost[int(action)];
+        int cost = Actions::dur_cost[int(action)];
+        if (effects[int(Effect::WasteNot)] != 0) cost = (cost + 1) / 2;
+        if (condition == Condition::Sturdy) cost = (cost + 1) / 2;
+        return cost;
     }
 
     unsigned get_progress_potency(const Action action) const {
-        float condition_pim = 1.00;
-        switch (condition) {
-            case Condition::Malleable: condition_pim = 1.50; break;
-            default:;
-        }
-        float effect_pim = 1.00;
-        if (effects[int(Effect::MuscleMemory)] > 0) effect_pim += 1.0;
-        if (effects[int(Effect::Veneration)] > 0) effect_pim += 0.5;
-        float action_pim = Actions::pim[int(action)];
-        return (unsigned)(condition_pim * effect_pim * action_pim);
+        // multipliers in quarters, 1.00 or 1.50 for the condition and 1.00 + 1.0 (Muscle Memory) + 0.5 (Veneration)
+        const unsigned condition_pim = condition == Condition::Malleable ? 6 : 4;
+        unsigned effect_pim = 4;
+        if (effects[int(Effect::MuscleMemory)] > 0) effect_pim += 4;
+        if (effects[int(Effect::Veneration)] > 0) effect_pim += 2;
+        return condition_pim * effect_pim * Actions::pim[int(action)] / 16;
     }
 
     unsigned get_quality_potency(const Action action) const {
-        float condition_qim = 1.00;
-        switch (condition) {
-            case Condition::Good: condition_qim = 1.50; break;
-            case Condition::Excellent: condition_qim = 4.00; break;
-            case Condition::Poor: condition_qim = 0.50; break;
-            default:;
-        }
-        float effect_qim = 1.00 + effects[int(Effect::InnerQuiet)] * 0.10;
-        if (effects[int(Effect::GreatStrides)] != 0) effect_qim += 1.0;
-        if (effects[int(Effect::Innovation)] != 0) effect_qim += 0.5;
-        float action_qim = Actions::qim[int(action)];
-        if (action == Action::ByregotsBlessing) action_qim += Config::BASE_QUALITY_MULTIPLIER * effects[int(Effect::InnerQuiet)] * 0.20;
-        return (unsigned)(condition_qim * effect_qim * action_qim);
+        return Actions::quality_potency[Actions::quality_condition[int(condition)]][effects[int(Effect::InnerQuiet)]]
+            [effects[int(Effect::GreatStrides)] != 0][effects[int(Effect::Innovation)] != 0][int(action)];
     }
 
-    bool can_use_action(const Action action) const {
+    template<Action action> bool can_use_action() const {
         if (cp < get_cp_cost(action)) return false;
         if (durability <= 0) return false;
 
-        if (Actions::combo_action[int(action)] != Action::Null && last_action != Actions::combo_action[int(action)]) return false;
-
-        switch (action) {
-            case Action::PreciseTouch:
-            case Action::IntensiveSynthesis:
-                return condition == Condition::Good || condition == Condition::Excellent;
-            case Action::PrudentTouch:
-            case Action::PrudentSynthesis:
-                return effects[int(Effect::WasteNot)] == 0;
-            case Action::Groundwork:
-                return durability >= get_durability_cost(action);
-            case Action::TrainedFinesse:
-                return effects[int(Effect::InnerQuiet)] == 10;
-            default:
-                return true;
-        }
+        if constexpr (Actions::combo_action[int(action)] != Action::Null)
+            if (last_action != Actions::combo_action[int(action)]) return false;
+
+        if constexpr (action == Action::PreciseTouch || action == Action::IntensiveSynthesis)
+            return condition == Condition::Good || condition == Condition::Excellent;
+        else if constexpr (action == Action::PrudentTouch || action == Action::PrudentSynthesis)
+            return effects[int(Effect::WasteNot)] == 0;
+        else if constexpr (action == Action::Groundwork)
+            return durability >= get_durability_cost(action);
+        else if constexpr (action == Action::TrainedFinesse)
+            return effects[int(Effect::InnerQuiet)] == 10;
+        else
+            return true;
     }
 
     void apply_effect(const Effect effect, const int stacks) {
         effects[int(effect)] = (condition == Condition::Primed ? stacks + 2 : stacks);
     }
 
-    State use_action(const Action action) const {
+    template<Action action> State use_action() const {
+        constexpr ActionInfo info = Actions::INFO[int(action)];
         State new_state = *this;
 
         new_state.cp -= get_cp_cost(action);
@@ -96,58 +112,75 @@ struct State {
                 new_state.effects[i] = std::max(0, new_state.effects[i] - 1);
 
         if (new_state.durability > 0) {
-            if (Actions::pim[int(action)] > 0.00)
-                new_state.effects[int(Effect::MuscleMemory)] = 0;
-
-            if (Actions::qim[int(action)] > 0.00) {
-                if (action == Action::PreciseTouch || action == Action::PreparatoryTouch || action == Action::Reflect)
-                    new_state.effects[int(Effect::InnerQuiet)] += 1;
-                new_state.effects[int(Effect::InnerQuiet)] = std::min(10, new_state.effects[int(Effect::InnerQuiet)] + 1);
-                if (action == Action::ByregotsBlessing)
-                    new_state.effects[int(Effect::InnerQuiet)] = 0;
-                new_state.effects[int(Effect::GreatStrides)] = 0;
+            if constexpr (info.progress_percent != 0)
+                if (Actions::pim[int(action)] > 0) new_state.effects[int(Effect::MuscleMemory)] = 0;
+
+            if constexpr (info.quality_percent != 0) {
+                if (Actions::qim[int(action)] > 0) {
+                    if constexpr (action == Action::PreciseTouch || action == Action::PreparatoryTouch || action == Action::Reflect)
+                        new_state.effects[int(Effect::InnerQuiet)] += 1;
+                    new_state.effects[int(Effect::InnerQuiet)] = std::min(10, new_state.effects[int(Effect::InnerQuiet)] + 1);
+                    if constexpr (action == Action::ByregotsBlessing)
+                        new_state.effects[int(Effect::InnerQuiet)] = 0;
+                    new_state.effects[int(Effect::GreatStrides)] = 0;
+                }
             }
 
             if (effects[int(Effect::Manipulation)] > 0)
-                new_state.durability = std::min(Config::MAX_DURABILITY, new_state.durability + 5);
-            if (action == Action::MasterMend)
-                new_state.durability = std::min(Config::MAX_DURABILITY, new_state.durability + 30);
-
-            if (action == Action::WasteNot) new_state.apply_effect(Effect::WasteNot, 4);
-            else if (action == Action::WasteNot2) new_state.apply_effect(Effect::WasteNot, 8);
-            else if (action == Action::Innovation) new_state.apply_effect(Effect::Innovation, 4);
-            else if (action == Action::Veneration) new_state.apply_effect(Effect::Veneration, 4);
-            else if (action == Action::GreatStrides) new_state.apply_effect(Effect::GreatStrides, 3);
-            else if (action == Action::MuscleMemory) new_state.apply_effect(Effect::MuscleMemory, 5);
-            else if (action == Action::Manipulation) new_state.apply_effect(Effect::Manipulation, 8);
+                new_state.durability = std::min(Actions::recipe.max_durability, new_state.durability + 5);
+            if constexpr (action == Action::MasterMend)
+                new_state.durability = std::min(Actions::recipe.max_durability, new_state.durability + 30);
+
+            if constexpr (action == Action::WasteNot) new_state.apply_effect(Effect::WasteNot, 4);
+            else if constexpr (action == Action::WasteNot2) new_state.apply_effect(Effect::WasteNot, 8);
+            else if constexpr (action == Action::Innovation) new_state.apply_effect(Effect::Innovation, 4);
+            else if constexpr (action == Action::Veneration) new_state.apply_effect(Effect::Veneration, 4);
+            else if constexpr (action == Action::GreatStrides) new_state.apply_effect(Effect::GreatStrides, 3);
+            else if constexpr (action == Action::MuscleMemory) new_state.apply_effect(Effect::MuscleMemory, 5);
+            else if constexpr (action == Action::Manipulation) new_state.apply_effect(Effect::Manipulation, 8);
         }
 
         return new_state;
     }
+
+    // runtime action, dispatched through a jump table to the specializations above
+    bool can_use_action(Action action) const;
+    State use_action(Action action) const;
 };
 
+bool State::can_use_action(const Action action) const {
+    static constexpr auto table = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<bool (State::*)() const, sizeof...(I)>{&State::can_use_action<Action(I)>...};
+    }(std::make_index_sequence<int(Action::COUNT)>());
+    return (this->*table[int(action)])();
+}
+
+State State::use_action(const Action action) const {
+    static constexpr auto table = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<State (State::*)() const, sizeof...(I)>{&State::use_action<Action(I)>...};
+    }(std::make_index_sequence<int(Action::COUNT)>());
+    return (this->*table[int(action)])();
+}
+
+static_assert(State::CP_BITS + State::DURABILITY_BITS + State::EFFECT_BITS * int(Effect::COUNT)
+    + State::CONDITION_BITS + State::ACTION_BITS <= 64, "State does not fit in 64 bits");
+static_assert(int(Condition::COUNT) <= 1 << State::CONDITION_BITS && int(Action::COUNT) < 1 << State::ACTION_BITS);
+static_assert(Recipe::CP_LIMIT < 1 << State::CP_BITS && Recipe::DURABILITY_LIMIT < 1 << State::DURABILITY_BITS);
+static_assert(Recipe().in_range(), "Config recipe does not fit in a State");
+static_assert(std::ranges::all_of(State::MAX_EFFECTS, [](const int max) { return max < 1 << State::EFFECT_BITS; }));
+
 template<> struct std::hash<State> {
     std::size_t operator()(State const& state) const noexcept {
-        static const size_t BASE = 1e9 + 7;
-        std::size_t params_hash = (state.cp * 256 + state.durability) * 16 + int(state.condition);
-        std::size_t action_hash = int(state.last_action);
-        std::size_t effect_hash = 0;
-        for (int x : state.effects) effect_hash = effect_hash * 16 + x;
-        return (params_hash * BASE + action_hash) * BASE + effect_hash;
+        return state.pack();
     }
 };
 
 bool operator == (const State lhs, const State rhs) {
-    return lhs.cp == rhs.cp
-        && lhs.durability == rhs.durability
-        && lhs.effects == rhs.effects
-        && lhs.condition == rhs.condition
-        && lhs.last_action == rhs.last_action;
+    return lhs.pack() == rhs.pack();
 }
 
 std::ostream &operator << (std::ostream &os, const State &state) { 
-    const std::size_t hash = std::hash<State>()(state);
-    os << std::hex << "([" << hash << "]" << std::dec;
+    os << std::hex << "([" << state.pack() << "]" << std::dec;
     os << " CP: " << state.cp << " Dur: " << state.durability << ")";
     return os;
-}
\ No newline at end of file
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+#include "enums.hpp"
+#include "actions.hpp"
+
+// Hot path counters of ParetoSolver. Build with -DSOLVER_STATS to collect them, otherwise every
+// update is discarded at compile time and the solver runs exactly as without instrumentation.
+struct SolverStats {
+#ifdef SOLVER_STATS
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+    static constexpr int MAX_DEPTH = 64; // deeper nodes are counted in the last bucket
+    static constexpr int FRONT_BUCKETS = 18; // bucket 0 holds empty fronts, bucket b lengths in [2^(b-1), 2^b)
+
+    std::uint64_t memo_hits = 0, memo_misses = 0;
+    std::uint64_t expanded_by_depth[MAX_DEPTH] = {};
+    std::uint64_t children_by_action[int(Action::COUNT)] = {}; // transitions taken
+    std::uint64_t rejected_can_use[int(Action::COUNT)] = {}, rejected_should_use[int(Action::COUNT)] = {};
+    std::uint64_t front_sizes[FRONT_BUCKETS] = {};
+    std::uint64_t merge_calls = 0, merge_ns = 0; // merge_pareto_fronts()
+    std::uint64_t build_calls = 0, build_ns = 0; // build_pareto_front()
+    std::uint32_t buf_high_water = 0, ind_high_water = 0;
+
+    static std::chrono::steady_clock::time_point now() { return std::chrono::steady_clock::now(); }
+
+    static std::uint64_t elapsed_ns(const std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(now() - since).count();
+    }
+
+    void record_front(const std::uint32_t length) {
+        int bucket = 0;
+        while (bucket + 1 < FRONT_BUCKETS && length >> bucket != 0) ++bucket;
+        ++front_sizes[bucket];
+    }
+
+    // adds the counters of a worker's solver
+    void merge(const SolverStats &other) {
+        memo_hits += other.memo_hits;
+        memo_misses += other.memo_misses;
+        for (int i = 0; i < MAX_DEPTH; ++i) expanded_by_depth[i] += other.expanded_by_depth[i];
+        for (int i = 0; i < int(Action::COUNT); ++i) {
+            children_by_action[i] += other.children_by_action[i];
+            rejected_can_use[i] += other.rejected_can_use[i];
+            rejected_should_use[i] += other.rejected_should_use[i];
+        }
+        for (int i = 0; i < FRONT_BUCKETS; ++i) front_sizes[i] += other.front_sizes[i];
+        merge_calls += other.merge_calls; merge_ns += other.merge_ns;
+        build_calls += other.build_calls; build_ns += other.build_ns;
+        buf_high_water = std::max(buf_high_water, other.buf_high_water);
+        ind_high_water = std::max(ind_high_water, other.ind_high_water);
+    }
+
+    void write_json(std::ostream &os) const {
+        auto write_array = [&](const std::uint64_t *values, const int length) {
+            int last = length; // trailing zeros are left out
+            while (last != 0 && values[last - 1] == 0) --last;
+            os << '[';
+            for (int i = 0; i < last; ++i) os << (i == 0 ? "" : ", ") << values[i];
+            os << ']';
+        };
+        auto write_by_action = [&](const std::uint64_t *values) {
+            os << '{';
+            bool first = true;
+            for (const Action action : ALL_ACTIONS) {
+                if (values[int(action)] == 0) continue;
+                os << (first ? "" : ", ") << '"' << Actions::display_name[int(action)] << "\": " << values[int(action)];
+                first = false;
+            }
+            os << '}';
+        };
+        os << "{\n  \"enabled\": " << (ENABLED ? "true" : "false")
+           << ",\n  \"memo_hits\": " << memo_hits << ", \"memo_misses\": " << memo_misses
+           << ",\n  \"expanded_by_depth\": "; write_array(expanded_by_depth, MAX_DEPTH);
+        os << ",\n  \"children_by_action\": "; write_by_action(children_by_action);
+        os << ",\n  \"rejected_can_use\": "; write_by_action(rejected_can_use);
+        os << ",\n  \"rejected_should_use\": "; write_by_action(rejected_should_use);
+        os << ",\n  \"front_size_log2_histogram\": "; write_array(front_sizes, FRONT_BUCKETS);
+        os << ",\n  \"merge\": {\"calls\": " << merge_calls << ", \"ns\": " << merge_ns << '}'
+           << ",\n  \"build\": {\"calls\": " << build_calls << ", \"ns\": " << build_ns << '}'
+           << ",\n  \"buf_high_water\": " << buf_high_water << ", \"ind_high_water\": " << ind_high_water
+           << "\n}\n";
+    }
+};
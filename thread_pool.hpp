@@ -0,0 +1,109 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <chrono>
+
+// Fixed-size pool where every worker owns a deque of tasks. Workers pop their own tasks LIFO
+// (depth-first, good locality) and steal the oldest task of another worker when they run dry.
+class WorkStealingPool {
+public:
+    struct TaskGroup {
+        std::atomic<std::size_t> pending{0};
+    };
+
+private:
+    struct Task {
+        std::function<void()> run;
+        TaskGroup *group;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    static thread_local int current; // index of the worker running on this thread, -1 if none
+
+    const unsigned n;
+    std::unique_ptr<Queue[]> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+    std::atomic<std::size_t> queued{0};
+    std::atomic<unsigned> next_queue{0};
+    bool stop = false;
+
+    bool __pop(const unsigned self, Task &task) {
+        for (unsigned k = 0; k != n; ++k) {
+            Queue &queue = queues[(self + k) % n];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            if (k == 0) { task = std::move(queue.tasks.back()); queue.tasks.pop_back(); }
+            else { task = std::move(queue.tasks.front()); queue.tasks.pop_front(); }
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void __run(Task &task) {
+        task.run();
+        task.group->pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    void __worker(const int self) {
+        current = self;
+        for (Task task;;) {
+            if (__pop(self, task)) { __run(task); continue; }
+            std::unique_lock<std::mutex> lock(idle_mutex);
+            idle.wait(lock, [&] { return stop || queued.load(std::memory_order_relaxed) != 0; });
+            if (stop) return;
+        }
+    }
+
+public:
+    explicit WorkStealingPool(const unsigned n): n(n), queues(std::make_unique<Queue[]>(n)) {
+        for (unsigned i = 0; i != n; ++i) threads.emplace_back(&WorkStealingPool::__worker, this, int(i));
+    }
+
+    ~WorkStealingPool() {
+        { std::lock_guard<std::mutex> lock(idle_mutex); stop = true; }
+        idle.notify_all();
+        for (std::thread &thread : threads) thread.join();
+    }
+
+    static int worker_index() { return current; }
+    unsigned size() const { return n; }
+
+    // schedules run() as part of group, on the calling worker's own queue if there is one
+    void submit(TaskGroup &group, std::function<void()> run) {
+        group.pending.fetch_add(1, std::memory_order_relaxed);
+        const unsigned index = current >= 0 ? unsigned(current) : next_queue.fetch_add(1) % n;
+        {
+            std::lock_guard<std::mutex> lock(queues[index].mutex);
+            queues[index].tasks.push_back(Task{std::move(run), &group});
+        }
+        { std::lock_guard<std::mutex> lock(idle_mutex); queued.fetch_add(1, std::memory_order_relaxed); }
+        idle.notify_one();
+    }
+
+    // blocks until every task of group has finished, workers keep running other tasks meanwhile
+    void wait(TaskGroup &group) {
+        Task task;
+        while (group.pending.load(std::memory_order_acquire) != 0) {
+            if (current >= 0 && __pop(unsigned(current), task)) __run(task);
+            else if (current >= 0) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+};
+
+thread_local int WorkStealingPool::current = -1;